@@ -51,7 +51,7 @@ else
 		
 		mv vpl_evaluate.cpp.save vpl_evaluate.cpp
 		check_program g++
-		g++ vpl_evaluate.cpp -Wall -Werror -std=c++17 -g -lm -lutil -o .vpl_tester
+		g++ vpl_evaluate.cpp -Wall -Werror -std=c++17 -g -pthread -lm -lutil -o .vpl_tester
 
 		#WIP/POG: placeholder for setting may_enhance
 		if [ -s vpl_enhance_env.sh ]
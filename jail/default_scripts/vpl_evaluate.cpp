@@ -12,11 +12,19 @@
 #include <errno.h>
 #include <sys/types.h>
 #include <sys/wait.h>
+#include <sys/resource.h>
+#include <sys/time.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <sys/prctl.h>
+#include <sys/mman.h>
+#include <dirent.h>
 #include <poll.h>
 #include <unistd.h>
 #include <pty.h>
 #include <fcntl.h>
 #include <signal.h>
+#include <sched.h>
 #include <cstring>
 #include <string>
 #include <iostream>
@@ -25,7 +33,19 @@
 #include <cmath>
 #include <execinfo.h>
 #include <regex.h>
+#if defined(__x86_64__) && defined(__GNUC__)
+#include <immintrin.h>
+#define VPL_X86_SIMD
+#endif
+// The evaluator is built without optimization, its inner loops are optimized anyway
+#if defined(__GNUC__) && ! defined(__clang__)
+#define VPL_OPTIMIZE __attribute__((optimize("O2")))
+#else
+#define VPL_OPTIMIZE
+#endif
 #include <string>
+#include <string_view>
+#include <charconv>
 #include <algorithm>
 
 //other required headers
@@ -36,6 +56,10 @@
 #include <memory>
 #include <map>
 #include <set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
 
 
 using namespace std;
@@ -43,7 +67,16 @@ using namespace std;
 const int MAXCOMMENTS = 20;
 const int MAXCOMMENTSLENGTH = 100*1024;
 const int MAXCOMMENTSTITLELENGTH = 1024;
+const int COMMENTSECTIONSIZE = 4 * 1024; // Bytes shown of the input and outputs of a failed case
+const int COMMENTSECTIONLINES = 40; // Lines shown of a large output of a failed case
+const int MAXDIFFEDITS = 128; // Line edits searched to find the differences of the outputs
+const int DIFFCONTEXT = 2; // Lines shown around a difference
 const int MAXOUTPUT = 256* 1024 ;//256Kb
+const int PIPEBUFSIZE = 64 * 1024; // Default capacity of a pipe
+const int MAXPIPEBUFSIZE = 1024 * 1024; // Default /proc/sys/fs/pipe-max-size
+const double EARLYSTOPWAIT = 0.1; // Seconds a program whose output can not match may take to end
+const double CHECKERTIMEOUT = 10; // Seconds a checker program may take
+const double MINCHECKERTIME = 1; // Seconds a checker may take even if the case time is spent
 
 
 ////////////////////////
@@ -668,8 +701,7 @@ namespace tokentools{
   }
 
   std::vector<std::string>
-  gettkns(std::string const& str, std::string const& form, std::string const& tkn="&$var"){
-    std::vector<std::string> const splt = strsplt(form, tkn);
+  gettkns(std::string const& str, std::vector<std::string> const& splt){
     std::vector<std::string> tkns;
     size_t c1=0, s1=0;
     for(size_t i=0; i<splt.size(); i++){
@@ -680,9 +712,13 @@ namespace tokentools{
     return tkns;
   }
 
+  std::vector<std::string>
+  gettkns(std::string const& str, std::string const& form, std::string const& tkn="&$var"){
+    return gettkns(str, strsplt(form, tkn));
+  }
+
   std::string
-  puttkns(std::string const& form, std::vector<std::string> const& tkns, std::string const& tkn="&$var"){
-    std::vector<std::string> const splt = strsplt(form, tkn);
+  puttkns(std::vector<std::string> const& splt, std::vector<std::string> const& tkns){
     std::string res;
     for(size_t i=0; i<splt.size(); i++){
       res += splt[i];
@@ -690,8 +726,134 @@ namespace tokentools{
     }
     return res;
   }
+
+  std::string
+  puttkns(std::string const& form, std::vector<std::string> const& tkns, std::string const& tkn="&$var"){
+    return puttkns(strsplt(form, tkn), tkns);
+  }
 }
 
+//messages of an enhance file, split when loaded. An Aho-Corasick automaton
+//of their fixed parts finds the message of a line in one pass
+struct EnhanceMatcher{
+  struct Pattern{
+    string id;
+    bool var; //has &$var
+    vector<string> splt; //parts around &$var
+    vector<int> parts; //non-empty parts (automaton outputs)
+    bool translated; //found in the lang file
+    string message; //translated message
+    vector<string> msplt; //translated message split
+  };
+
+  vector<Pattern>
+  patterns; //in the order of the json object, the first that matches is used
+
+  unordered_map<string, size_t>
+  exact; //messages without &$var
+
+  int nparts=0, nclasses=1;
+  unsigned char cls[256]; //class of each char, 0 if not in any part
+  vector<int> next; //transitions, nclasses per state
+  vector<vector<int>> out; //parts that end in each state
+
+  void
+  build(json::Object const& df, json::jsonWrapper const& lang){
+    map<string, int> partIds;
+    for (auto const& [id, _data] : df){
+      Pattern p;
+      p.id = id;
+      string const& data = _data->get<json::String>();
+      p.var = data.find("&$var")!=string::npos;
+      if (p.var){
+        p.splt = tokentools::strsplt(data, "&$var");
+        for(string const& s: p.splt){
+          if(s.size()==0) continue;
+          auto r = partIds.emplace(s, (int) partIds.size());
+          p.parts.push_back(r.first->second);
+        }
+      }
+      else exact.emplace(data, patterns.size());
+      p.translated = lang.find(id);
+      if (p.translated){
+        p.message = lang.at(id).get<json::String>();
+        p.msplt = tokentools::strsplt(p.message, "&$var");
+      }
+      patterns.emplace_back(p);
+    }
+    nparts = partIds.size();
+    memset(cls, 0, sizeof(cls));
+    for (auto const& [part, n] : partIds)
+      for(unsigned char c: part)
+        if(cls[c]==0) cls[c] = nclasses++;
+    //trie
+    next.assign(nclasses, -1);
+    out.assign(1, vector<int>());
+    for (auto const& [part, n] : partIds){
+      int st = 0;
+      for(unsigned char c: part){
+        int& t = next[st*nclasses + cls[c]];
+        if(t<0){
+          t = out.size();
+          out.emplace_back();
+          next.insert(next.end(), nclasses, -1);
+        }
+        st = next[st*nclasses + cls[c]];
+      }
+      out[st].push_back(n);
+    }
+    //failure links, missing transitions follow them
+    vector<int> fail(out.size(), 0);
+    vector<int> queue;
+    for(int c=0; c<nclasses; c++){
+      int& t = next[c];
+      if(t<0) t = 0;
+      else queue.push_back(t);
+    }
+    for(size_t q=0; q<queue.size(); q++){
+      int st = queue[q];
+      for(int f: out[fail[st]]) out[st].push_back(f);
+      for(int c=0; c<nclasses; c++){
+        int& t = next[st*nclasses + c];
+        if(t<0) t = next[fail[st]*nclasses + c];
+        else{
+          fail[t] = next[fail[st]*nclasses + c];
+          queue.push_back(t);
+        }
+      }
+    }
+  }
+
+  //first pattern that matches info and its tokens, nullptr if none
+  Pattern const*
+  match(string const& info, vector<string>& tkns) const{
+    size_t first = patterns.size();
+    auto e = exact.find(info);
+    if(e!=exact.end()) first = e->second;
+    vector<char> seen(nparts, 0);
+    int st = 0;
+    for(unsigned char c: info){
+      st = next[st*nclasses + cls[c]];
+      for(int f: out[st]) seen[f] = 1;
+    }
+    for(size_t i=0; i<first; i++){
+      Pattern const& p = patterns[i];
+      if(!p.var) continue;
+      bool found = true;
+      for(int f: p.parts)
+        if(!seen[f]){
+          found = false;
+          break;
+        }
+      if(found){
+        tkns = tokentools::gettkns(info, p.splt);
+        return &p;
+      }
+    }
+    return first<patterns.size()? &patterns[first]: nullptr;
+  }
+};
+
 bool may_enhance=false;
 
 
@@ -717,6 +879,9 @@ struct Interface{
   json::jsonWrapper
   enhance;
 
+  map<string, EnhanceMatcher>
+  matchers;
+
   bool _loaded_evaluate=false, _loaded_enhance=false;
 
   /* methods */
@@ -781,6 +946,8 @@ struct Interface{
         }
         enhance(_file)(_lang) = enhance[_file]["default"];
       }
+      for(string& _file : _files)
+        matchers[_file].build(enhance.at(_file).at("default").get<json::Object>(), enhance.at(_file).at(_lang));
       _loaded_enhance = true;
     }
     catch (json::ParseError &e){
@@ -796,7 +963,7 @@ struct Interface{
   }
 
   string
-  langEvaluate(int const id){
+  langEvaluate(int const id) const{
     if(evaluate.find(_lang)){
       if(evaluate.at(_lang).find(to_string(id)))
         return evaluate.at(_lang).at(to_string(id)).get<json::String>();
@@ -809,42 +976,25 @@ struct Interface{
   }
 
   std::pair<string, std::vector<std::string>>
-  _getridtkns(string const& info, string const& file){
-    json::Object const df = enhance[file]["default"].get<json::Object>();
-    for (auto const& [id, _data] : df){
-      auto data = _data->get<json::String>();
-      if (data.find("&$var")!=string::npos){
-        vector<string> v = tokentools::strsplt(data, "&$var");
-        bool match = true;
-        for(string const& s: v){
-          if(info.find(s)==string::npos){
-            vector<string>().swap(v);
-            match = false;
-            break;
-          }
-        }
-        if (match){
-          vector<string> rt = tokentools::gettkns(info, data);
-          return {id, rt};
-        }
-      }
-      else if(info == data) return {id, vector<string>()};
-    }
-    return {"", vector<string>()};
+  _getridtkns(string const& info, string const& file) const{
+    vector<string> tkns;
+    EnhanceMatcher::Pattern const* p = matchers.at(file).match(info, tkns);
+    if (p == nullptr) return {"", vector<string>()};
+    return {p->id, tkns};
   }
 
   // WIP
   string
-  enhanceMessageDiv(string const& info, string const& file=""){
+  enhanceMessageDiv(string const& info, string const& file="") const{
     string const fl = (file==""? _files.at(0): file);
     auto [id, tkn] = _getridtkns(info, fl);
     if(id=="")
       return "<case>" + info;
     if(tkn.size()==0)
-      return "<caseEnhanced>" + enhance[fl][_lang][id].get<json::String>() + "<caseOriginal>" + info;
+      return "<caseEnhanced>" + enhance.at(fl).at(_lang).at(id).get<json::String>() + "<caseOriginal>" + info;
     return "<caseEnhanced>"
     + tokentools::puttkns(
-      enhance[fl][_lang][id].get<json::String>(),
+      enhance.at(fl).at(_lang).at(id).get<json::String>(),
       tkn
       )
     + "<caseOriginal>"
@@ -852,21 +1002,21 @@ struct Interface{
   }
 
   string
-  enhanceMessage(string const& info, string const& file=""){
+  enhanceMessage(string const& info, string const& file="") const{
     string const fl = (file==""? _files.at(0): file);
-    auto [id, tkn] = _getridtkns(info, fl);
-    if(id=="")
+    vector<string> tkn;
+    EnhanceMatcher::Pattern const* p = matchers.at(fl).match(info, tkn);
+    if(p==nullptr)
       return info;
+    if(!p->translated) //as before, out_of_range
+      return enhance.at(fl).at(_lang).at(p->id).get<json::String>();
     if(tkn.size()==0)
-      return enhance[fl][_lang][id].get<json::String>();
-    return
-      tokentools::puttkns(
-      enhance[fl][_lang][id].get<json::String>(),
-      tkn
-      );
+      return p->message;
+    return tokentools::puttkns(p->msplt, tkn);
   }
 };
 
+// Loaded once in main; only const (read-only) methods are used while test cases run
 Interface* L;
 
 
@@ -878,7 +1028,8 @@ public:
 	static bool existFile(string name);
 	static string readFile(string name);
 	static vector<string> splitLines(const string &data);
-	static int nextLine(const string &data);
+	static string headLines(const string &text, size_t size);
+	static int nextLine(const string &data, size_t from = 0);
 	static string caseFormat(string text, bool enhance/*=false||may_enhance*/);
 	static string toLower(const string &text);
 	static string normalizeTag(const string &text);
@@ -886,10 +1037,24 @@ public:
 	static string trimRight(const string &text);
 	static string trim(const string &text);
 	static void fdblock(int fd, bool set);
+	static int pidfdOpen(pid_t pid);
+	static int memfdCreate(const char *name);
+	static int memfdWith(const char *name, const char *data, size_t size);
+	static bool procUsage(pid_t pid, struct rusage &usage);
+	static void subUsage(struct rusage &usage, const struct rusage &before);
+	static double seconds(const struct timeval &tv);
+	static int endProcessGroup(pid_t pgid, struct rusage &usage, bool &leaderReaped);
+	static int endChildren();
+	static rlim_t userTasks();
 	static bool convert2(const string& str, double &data);
+	static bool convert2Size(const string& str, double &data);
 	static bool convert2(const string& str, long int &data);
+	static bool parseNumber(const string& str, double &data);
+	static bool parseNumber(const string& str, long int &data, bool &valid);
 	static const char* getenv(const char* name, const char* defaultvalue);
 	static double getenv(const char* name, double defaultvalue);
+	static double getenvOption(const char* name, double defaultvalue);
+	static const char* getenvOption(const char* name, const char* defaultvalue);
 };
 
 /**
@@ -906,10 +1071,11 @@ public:
  * Class Timer Declaration
  */
 class Timer{
-	static time_t startTime;
+	static double startTime;
 public:
+	static double now();
 	static void start();
-	static int elapsedTime();
+	static double elapsedTime();
 };
 
 /**
@@ -921,6 +1087,18 @@ public:
 	const char *get_string(const char *s);
 };
 
+/**
+ * Interface OutputStreamChecker
+ * Checks the output while the program writes it, to know early that it can not match
+ */
+class OutputStreamChecker{
+public:
+	virtual ~OutputStreamChecker(){};
+	virtual bool add(const char *data, size_t size)=0; // false if the output can not match
+};
+
+class ParsedOutput;
+
 /**
  * Interface OutputChecker
  */
@@ -936,13 +1114,37 @@ public:
 	virtual string outputExpected(){return text;}
 	virtual string studentOutputExpected(){return text;}
 	virtual bool match(const string&)=0;
+	virtual bool matchParsed(ParsedOutput &output); // Uses the forms already parsed
+	virtual OutputStreamChecker* streamChecker(){return NULL;} // NULL if not available
+	virtual string getMessage(){return "";} // About the last match, "" if none
 	virtual OutputChecker* clone()=0;
 };
 
+/**
+ * Class NumberScanner Declaration
+ * Finds where numbers start and end in an output, many chars at once
+ * with SSE2 or AVX2 (chosen by the CPU) or one by one
+ */
+class NumberScanner{
+	static int level; // 0 one by one, 1 SSE2, 2 AVX2, -1 not chosen yet
+	static size_t findScalar(const char *data, size_t from, size_t size, bool start);
+#ifdef VPL_X86_SIMD
+	static size_t findSSE2(const char *data, size_t from, size_t size, bool start);
+	static size_t findAVX2(const char *data, size_t from, size_t size, bool start);
+#endif
+public:
+	static void init();
+	static bool isNum(char c);
+	static bool isNumStart(char c);
+	static size_t findStart(const char *data, size_t from, size_t size);
+	static size_t findEnd(const char *data, size_t from, size_t size);
+};
+
 /**
  * Class NumbersOutput Declaration
  */
 class NumbersOutput:public OutputChecker{
+public:
 	struct Number{
 		bool isInteger;
 		long int integer;
@@ -954,6 +1156,7 @@ class NumbersOutput:public OutputChecker{
 		operator string () const;
 	};
 
+private:
 	vector<Number> numbers;
 	bool startWithAsterisk;
 	string cleanText;
@@ -961,14 +1164,29 @@ class NumbersOutput:public OutputChecker{
 	static bool isNum(char c);
 	static bool isNumStart(char c);
 	bool calcStartWithAsterisk();
+	bool matchNumbers(const vector<Number> &output)const;
+
+	// Compares each number of the output when it ends
+	class StreamChecker:public OutputStreamChecker{
+		const vector<Number> &numbers;
+		size_t found;
+		string str;
+	public:
+		StreamChecker(const vector<Number> &numbers):numbers(numbers),found(0){}
+		bool add(const char *data, size_t size);
+	};
 
 public:
 	NumbersOutput(const string &text);//:OutputChecker(text);
 	string studentOutputExpected();
 	bool operator==(const NumbersOutput& o)const;
 	bool match(const string& output);
+	bool matchParsed(ParsedOutput &output);
+	OutputStreamChecker* streamChecker();
 	OutputChecker* clone();
 	static bool typeMatch(const string& text);
+	static void parse(const char *data, size_t size, string &str, vector<Number> &numbers);
+	static void parseEnd(string &str, vector<Number> &numbers);
 	string type();
 	operator string () const;
 };
@@ -977,18 +1195,44 @@ public:
  * Class TextOutput Declaration
  */
 class TextOutput:public OutputChecker{
-	vector<string> tokens;
-	bool isAlpha(char c);
+	string folded; // Lowercase text, the tokens point to it
+	vector<string_view> tokens;
+	static bool isAlpha(char c);
+	bool matchTokens(const vector<string_view> &output);
 
 public:
 	TextOutput(const string &text);//:OutputChecker(text);
 	bool operator==(const TextOutput& o);
 	bool match(const string& output);
+	bool matchParsed(ParsedOutput &output);
 	OutputChecker* clone();
 	static bool typeMatch(const string& text);
+	static void fold(const char *data, size_t size, string &folded);
+	static void split(const string &folded, vector<string_view> &tokens);
 	string type();
 };
 
+/**
+ * Class ParsedOutput Declaration
+ * Output of a program in the forms compared by the outputs of a case,
+ * each form built once when first needed. The output may come in two parts
+ */
+class ParsedOutput{
+	const string &first, &second;
+	string text; // Both parts, if there are two
+	bool textBuilt;
+	vector<NumbersOutput::Number> numbers;
+	bool numbersBuilt;
+	string folded; // Both parts in lowercase, the words point to it
+	vector<string_view> words;
+	bool wordsBuilt;
+public:
+	ParsedOutput(const string &first, const string &second);
+	const string &getText();
+	const vector<NumbersOutput::Number> &getNumbers();
+	const vector<string_view> &getWords();
+};
+
 /**
  * Class ExactTextOutput Declaration
  */
@@ -997,16 +1241,50 @@ class ExactTextOutput:public OutputChecker{
 	bool startWithAsterix;
 	bool isAlpha(char c);
 
+	// Compares the output with the text while it arrives
+	class StreamChecker:public OutputStreamChecker{
+		const string &text;
+		size_t found;
+	public:
+		StreamChecker(const string &text):text(text),found(0){}
+		bool add(const char *data, size_t size);
+	};
+
 public:
 	ExactTextOutput(const string &text);//:OutputChecker(text);
 	string studentOutputExpected();
 	bool operator==(const ExactTextOutput& o);
 	bool match(const string& output);
+	OutputStreamChecker* streamChecker();
 	OutputChecker* clone();
 	static bool typeMatch(const string& text);
 	string type();
 };
 
+/**
+ * Interface RegexEngine
+ * Compiled regular expression, matched against a piece of memory
+ */
+class RegexEngine{
+public:
+	virtual ~RegexEngine(){};
+	virtual int match(const char *data, size_t size)=0; // 0, REG_NOMATCH or an error code
+};
+
+/**
+ * Class PosixRegex Declaration
+ * POSIX extended regular expression of the C library
+ */
+class PosixRegex:public RegexEngine{
+	regex_t expression;
+	bool compiled;
+	PosixRegex():compiled(false){}
+public:
+	static PosixRegex* compile(const string &pattern, int flags, string &error);
+	~PosixRegex();
+	int match(const char *data, size_t size);
+};
+
 /**
  * Class RegularExpressionOutput Declaration
  * Regular Expressions implemented by:
@@ -1017,10 +1295,13 @@ public:
 class RegularExpressionOutput:public OutputChecker {
 	string errorCase;
 	string cleanText;
-	regex_t expression;
 	bool flagI;
 	bool flagM;
-	int reti;
+	shared_ptr<RegexEngine> engine; // Compiled once, shared by the clones
+	string literal; // Text that any match contains, "" if not known
+
+	static string requiredLiteral(const string &pattern);
+	void fatalError(const string &message);
 
 public:
 	RegularExpressionOutput (const string &text, const string &actualCaseDescription);
@@ -1038,6 +1319,100 @@ public:
 
 	string type();
 };
+/**
+ * Class CheckerOutput Declaration
+ * The output is checked by a program of the teacher (checker=). It gets the paths
+ * of the input, the expected output and the program output as arguments, files
+ * also open as its fds 3, 4 and 5. Exit code 0 means that the output is correct,
+ * what the checker writes is added to the comment of the case.
+ */
+class CheckerOutput:public OutputChecker {
+	vector<string> args; // Command and arguments
+	string input;
+	string inputFile;
+	string message; // Written by the checker in the last match
+	double timeLimit; // Seconds the checker may take
+
+	bool run(const int fds[3]);
+	void addMessage(const char *data, size_t size);
+public:
+	CheckerOutput(const string &command, const string &expected, const string &input,
+			const string &inputFile);
+	bool match(const string& output);
+	void setTimeLimit(double timeLimit);
+	string getMessage();
+	OutputChecker* clone();
+	string type();
+};
+
+/**
+ * Class CaseLimits Declaration
+ * Resource limits of the program of a case, 0 = no limit
+ */
+class CaseLimits {
+public:
+	rlim_t memory; // Bytes of address space
+	rlim_t cputime; // Seconds
+	rlim_t filesize; // Bytes
+	rlim_t processes; // Of the case with VPL_EVAL_CGROUP, else more than the user had at its start
+	size_t output; // Bytes of output kept, 0 = MAXOUTPUT
+	CaseLimits();
+	bool operator==(const CaseLimits &o) const;
+};
+
+/**
+ * Class OutputBuffer Declaration
+ * Program output of fixed capacity. If the output is larger it keeps
+ * its beginning and its end, the end in a circular buffer.
+ */
+class OutputBuffer {
+	size_t capacity;
+	size_t total; // Bytes appended
+	string data; // The output or, if truncated, its beginning
+	string tail; // Circular buffer with the end of a truncated output
+	size_t tailPos; // Oldest byte of tail
+	string joined; // Contiguous view of a truncated output
+	bool joinedValid;
+	void appendTail(const char *buf, size_t size);
+public:
+	OutputBuffer();
+	void setCapacity(size_t capacity);
+	size_t getCapacity() const;
+	void clear();
+	void append(const char *buf, size_t size);
+	bool isTruncated() const;
+	bool empty() const;
+	size_t size() const;
+	const string &view();
+	void resize(size_t size);
+};
+
+/**
+ * Class LineDiff Declaration
+ * Lines that differ between the expected output and the program output,
+ * with the Myers O(ND) diff limited to MAXDIFFEDITS edits. Gives excerpts
+ * of the outputs around the first differences
+ */
+class LineDiff {
+	struct Hunk {
+		size_t expectedFrom, expectedTo, programFrom, programTo;
+	};
+	vector<string_view> expected, program;
+	vector<size_t> expectedHash, programHash;
+	vector<Hunk> hunks;
+	size_t firstProgramLine;
+	static void split(const string &text, vector<string_view> &lines, vector<size_t> &hashes);
+	bool equal(size_t e, size_t p) const;
+	bool diff(size_t eFrom, size_t eTo, size_t pFrom, size_t pTo);
+	void addContext();
+	string excerpt(const vector<string_view> &lines, bool isExpected, size_t budget, int maxLines) const;
+public:
+	LineDiff(const string &expected, const string &program);
+	size_t getFirstProgramLine() const; // Line number, from 1
+	string expectedExcerpt(size_t budget, int maxLines) const;
+	string programExcerpt(size_t budget, int maxLines) const;
+};
+
 /**
  * Class Case Declaration
  * Case represents cases
@@ -1051,6 +1426,12 @@ class Case {
 	string programToRun;
 	string programArgs;
 	int expectedExitCode; // Default value std::numeric_limits<int>::min()
+	double timeout; // Seconds, 0 if not set
+	bool persistent;
+	string inputEnd, outputEnd; // Marks of the end of case for persistent programs
+	CaseLimits limits;
+	string inputFile;
+	string checker; // Command of the checker program, "" if none
 	string variation;
 public:
 	Case();
@@ -1071,10 +1452,98 @@ public:
 	string getProgramToRun();
 	void setProgramArgs(const string &);
 	string getProgramArgs();
+	void setTimeout(double);
+	double getTimeout();
+	void setPersistent(const string &inputEnd, const string &outputEnd);
+	bool isPersistent();
+	string getInputEnd();
+	string getOutputEnd();
+	CaseLimits &getLimits();
+	void setInputFile(const string &);
+	string getInputFile();
+	void setChecker(const string &);
+	string getChecker();
 	void setVariation(const string &);
 	string getVariation();
 };
 
+/**
+ * Class Cgroup Declaration
+ * A cgroup v2 leaf for the program of a case, under a delegated base cgroup.
+ * Limits the program and all its descendants and accounts their usage.
+ */
+class Cgroup {
+	static string base; // "" cgroups not used
+	static rlim_t defaultMemory, defaultProcesses;
+	static double cpus; // CPUs for each program, 0 no limit
+	static atomic<unsigned> nextId;
+	string path;
+	int procsFd;
+	rlim_t memoryLimit;
+	static bool writeFile(const string &fname, const string &value);
+public:
+	static void setup(const string &base, rlim_t memory, rlim_t processes, double cpus);
+	static bool isEnabled();
+	Cgroup();
+	~Cgroup();
+	bool create(const CaseLimits &limits);
+	int getProcsFd();
+	bool readUsage(struct rusage &usage);
+	bool isOOMKilled();
+	rlim_t getMemoryLimit();
+	void destroy();
+};
+
+/**
+ * Class ProcessLauncher Declaration
+ * Starts a program with clone(CLONE_VM | CLONE_VFORK): until execve the child
+ * runs in the memory of the evaluator, avoiding fork's copy of its page tables.
+ */
+class ProcessLauncher {
+	static const int STACKSIZE = 64 * 1024;
+	const char *command;
+	const char **argv;
+	const char **envv;
+	int fdin, fdout;
+	const int *extraFds; // Given to the program as fds 3, 4...
+	int nextraFds;
+	const CaseLimits &limits;
+	int cgroupFd; // cgroup.procs of the cgroup for the program, -1 none
+	rlim_t userTasks; // Tasks of the user before the launch, RLIMIT_NPROC counts them
+	sigset_t parentMask;
+	volatile int execError; // errno of a failed execve, set by the child
+	static int child(void *launcher);
+	static void setLimit(int resource, rlim_t soft, rlim_t hard);
+public:
+	ProcessLauncher(const char *command, const char **argv, const char **envv, int fdin, int fdout,
+			const CaseLimits &limits);
+	void setCgroup(int cgroupFd);
+	void setExtraFds(const int *fds, int n);
+	pid_t launch();
+	int getExecError();
+};
+
+/**
+ * Class PersistentProcess Declaration
+ * A program that runs consecutive test cases, one after another.
+ * Each case input is followed by the inputend= line and the program
+ * writes the outputend= mark after the output of each case.
+ */
+class PersistentProcess {
+	friend class TestCase;
+	string key; // Program and arguments
+	pid_t pid;
+	int fdwrite, fdread, pidfd;
+	Cgroup cgroup;
+public:
+	PersistentProcess();
+	~PersistentProcess();
+	bool isRunning(const string &key);
+	void start(const string &key, pid_t pid, int fdwrite, int fdread);
+	void release();
+	int stop();
+};
+
 /**
  * Class TestCase Declaration
  * TestCase represents cases to tested
@@ -1086,6 +1555,7 @@ class TestCase {
 	int id;
 	bool correctOutput;
 	bool outputTooLarge;
+	bool outputMismatch; // The output can not match, the program was stopped
 	bool programTimeout;
 	bool executionError;
 	bool correctExitCode;
@@ -1102,49 +1572,183 @@ class TestCase {
 	string variantion;
 	int expectedExitCode; // Default value std::numeric_limits<int>::min()
 	int exitCode; // Default value std::numeric_limits<int>::min()
-	string programOutputBefore, programOutputAfter, programInput;
-
-	void cutOutputTooLarge(string &output);
-	void readWrite(int fdread, int fdwrite);
+	double timeout; // Seconds, 0 if not set
+	double duration; // Seconds running the program
+	double checkDuration; // Seconds checking its output, checker programs included
+	bool persistent;
+	string inputEnd, outputEnd;
+	struct rusage usage; // Resources used by the program
+	bool usageAvailable;
+	string inputFile; // File for the standard input, "" input= is used
+	CaseLimits limits;
+	string limitReason; // Limit exceeded by the program, "" if none
+	int strays; // Processes left by the program and ended by the evaluator
+	OutputBuffer programOutputBefore, programOutputAfter;
+	string programInput;
+	size_t programInputSent; // Bytes of programInput written
+	static bool lineInput; // Writes the input line by line, as the program reads it
+	static bool fileCapture; // The output goes to a file in memory instead of a pipe
+	static bool earlyStop; // Stops the program when its output can not match
+	vector< unique_ptr<OutputStreamChecker> > streamCheckers; // Outputs that still can match
+
+	void readWrite(int &fdread, int &fdwrite, int pidfd, int waitms, bool closeInput = true);
 	void addOutput(const string &o, const string &actualCaseDescription);
+	bool startProgram(pid_t &pid, int &fdwrite, int &fdread, Cgroup &cgroup, int fdoutput = -1);
+	int openOutput();
+	void loadOutput(int fdoutput);
+	void setCgroupUsage(Cgroup &cgroup);
+	void setProgramEnd(int status);
+	void setLimitReason(int status);
+	bool isMemoryExhausted();
+	void runPersistentTest(double timeout, PersistentProcess &process);
 public:
 	static void setEnvironment(const char **environment);
+	static void setLineInput(bool lineInput);
+	static void setFileCapture(bool fileCapture);
+	static void setEarlyStop(bool earlyStop);
 	void setDefaultCommand();
 	TestCase(const TestCase &o);
 	TestCase& operator=(const TestCase &o);
 	~TestCase();
 	TestCase(int id, const string &input, const vector<string> &output,
 			const string &caseDescription, const float gradeReduction,
-		    string failMessage, string programToRun, string programArgs, int expectedExitCode);
+		    string failMessage, string programToRun, string programArgs, int expectedExitCode,
+		    double timeout);
 	bool isCorrectResult();
 	bool isExitCodeTested();
 	float getGradeReduction();
+	double getTimeout();
+	double getDuration();
+	double getCheckDuration();
+	bool isTimeout();
+	bool isUsageAvailable();
+	const struct rusage &getUsage();
+	int getExitCode();
+	int getStrays();
+	void setPersistent(const string &inputEnd, const string &outputEnd);
+	void setLimits(const CaseLimits &limits);
+	void setInputFile(const string &inputFile);
+	void setChecker(const string &checker, const vector<string> &expected);
+	bool sharesProcessWith(const TestCase &o);
 	void setGradeReductionApplied(float r);
 	float getGradeReductionApplied();
 	string getCaseDescription();
 	string getCommentTitle(bool withGradeReduction/*=false*/); // Suui
 	string getComment();
+	string getInputFileSummary();
 	void splitArgs(string);
-	void runTest(time_t timeout);
-	bool match(string data);
+	void runTest(double timeout);
+	void runTest(double timeout, PersistentProcess &process);
+	bool match(ParsedOutput &data, bool checkers);
+	bool matchOutput(double timeLeft);
+};
+
+/**
+ * Class TimeBudget Declaration
+ * Shares the evaluation time among the test cases.
+ * The time not used by a case goes to the cases that remain.
+ */
+class TimeBudget {
+	double maxtime;
+	double minCaseTime, maxCaseTime; // Limits of the default share, 0 = no limit
+	size_t lanes; // Cases running at the same time
+	size_t pendingCases; // Cases without timeout= not started
+	double pendingRequested; // Time requested with timeout= by cases not started
+	double used;
+	int nruns, ntimeouts;
+	mutex budgetMutex;
+public:
+	TimeBudget(double maxtime, vector<TestCase> &testCases, size_t lanes,
+			double minCaseTime, double maxCaseTime);
+	bool exhausted();
+	double allocate(double requested);
+	void release(double duration, bool timeout);
+	void report();
+};
+
+/**
+ * Class CaseHistory Declaration
+ * Durations and results of previous evaluations, by case description.
+ * Used to choose the order to run the test cases.
+ */
+class CaseHistory {
+	struct Entry {
+		double duration; // Mean of recent runs
+		unsigned runs, failures;
+	};
+	map<string, Entry> entries;
+public:
+	void load(const string &fname);
+	void save(const string &fname);
+	void record(const string &description, double duration, bool failed);
+	double getDuration(const string &description, double defaultvalue);
+	double getFailureRate(const string &description, double defaultvalue);
+};
+
+/**
+ * Class TestCasePool Declaration
+ * Runs test cases concurrently on a bounded set of worker threads.
+ * Cases start in run order. Consecutive cases sharing a persistent
+ * program run in the same worker.
+ * The caller consumes the results in the order the cases finish.
+ */
+class TestCasePool {
+public:
+	enum CaseState {
+		pending, running, done, notRun
+	};
+private:
+	vector<TestCase> &testCases;
+	vector<size_t> runOrder;
+	vector<CaseState> states;
+	vector<size_t> finished; // Cases done or not run, in finishing order
+	size_t nconsumed;
+	vector<thread> workers;
+	mutex poolMutex;
+	condition_variable caseFinished;
+	size_t nextCase;
+	TimeBudget &budget;
+	bool stopping;
+	atomic<int> strays; // Processes left by persistent programs
+	void work();
+public:
+	TestCasePool(vector<TestCase> &testCases, const vector<size_t> &runOrder, TimeBudget &budget);
+	~TestCasePool();
+	void start(size_t nworkers);
+	size_t waitNext(CaseState &state);
+	void requestStop();
+	void stop();
+	int getStrays();
 };
 
 /**
  * Class Evaluation Declaration
  */
 class Evaluation {
-	int maxtime;
+	double maxtime;
+	double minCaseTime, maxCaseTime;
+	int jobs;
+	bool failFast; // Stops when the grade can not be lower
+	int maxTimeouts; // Stops after this number of consecutive timeouts, 0 no limit
+	string notRunReason, notRunCases;
+	string historyFile; // Sidecar file with the case history, "" no history
+	string order; // Run order: "" as in file, "cost", "failure" or "value"
+	CaseHistory history;
+	string resourcesFile; // File for the resources used by each case, "" not written
 	float grademin, grademax;
 	string variation;
 	bool noGrade;
 	float grade;
 	int nerrors, nruns;
+	int nfailedNotRun; // Cases not run that count as failed
+	vector<size_t> runCases; // Cases run, in case order
 	vector<TestCase> testCases;
 	char comments[MAXCOMMENTS + 1][MAXCOMMENTSLENGTH + 1];
 	char titles[MAXCOMMENTS + 1][MAXCOMMENTSTITLELENGTH + 1];
 	char titlesGR[MAXCOMMENTS + 1][MAXCOMMENTSTITLELENGTH + 1];
 	volatile int ncomments;
 	volatile bool stopping;
+	recursive_mutex commentsMutex; // Fatal errors may be reported from test runners
 	static Evaluation *singlenton;
 	Evaluation();
 
@@ -1154,9 +1758,16 @@ public:
 	void addTestCase(Case &);
 	void removeLastNL(string &s);
 	bool cutToEndTag(string &value, const string &endTag);
+	void setPersistent(Case &caso, int &persistentLine,
+			const string &inputEnd, const string &outputEnd);
 	void loadTestCases(string fname);
 	bool loadParams();
 	void addFatalError(const char *m);
+	void addNotRunCases(vector<size_t> cases, const string &reason, bool failed, float defaultGradeReduction);
+	void applyGradeReduction(TestCase &testCase, float defaultGradeReduction);
+	void reportCase(size_t i, bool announce);
+	vector<size_t> getRunOrder(float defaultGradeReduction);
+	void saveResources();
 	void runTests();
 	void outputEvaluationEnhance();
 	void outputEvaluation();
@@ -1175,8 +1786,16 @@ public:
 /////////////////////////////////////////////////////////////////////////////////////////////////
 
 volatile bool Stop::TERMRequested = false;
-time_t Timer::startTime;
+double Timer::startTime;
 const char **TestCase::envv=NULL;
+bool TestCase::lineInput = false;
+bool TestCase::fileCapture = false;
+bool TestCase::earlyStop = true;
+string Cgroup::base;
+rlim_t Cgroup::defaultMemory = 0;
+rlim_t Cgroup::defaultProcesses = 0;
+double Cgroup::cpus = 0;
+atomic<unsigned> Cgroup::nextId(0);
 Evaluation* Evaluation::singlenton = NULL;
 
 /**
@@ -1227,10 +1846,25 @@ vector<string> Tools::splitLines(const string &data) {
 	return lines;
 }
 
-int Tools::nextLine(const string &data) {
-	int l = data.size();
+// The lines of text that fit in size, "..." if some are left out
+string Tools::headLines(const string &text, size_t size) {
+	if (text.size() <= size) {
+		return text;
+	}
+	size_t end = text.rfind('\n', size - 1);
+	end = end == string::npos ? size : end + 1;
+	string res = text.substr(0, end);
+	if (end == size) {
+		res += '\n';
+	}
+	return res + "...\n";
+}
+
+// Size of the line that begins at from
+int Tools::nextLine(const string &data, size_t from) {
+	int l = data.size() - from;
 	for (int i = 0; i < l; i++) {
-		if (data[i] == '\n')
+		if (data[from + i] == '\n')
 			return i + 1;
 	}
 	return l;
@@ -1323,20 +1957,285 @@ void Tools::fdblock(int fd, bool set) {
 	fcntl(fd, F_SETFL, flags);
 }
 
+// Returns a descriptor that becomes readable when the process ends, -1 if not supported
+int Tools::pidfdOpen(pid_t pid) {
+#ifdef SYS_pidfd_open
+	return syscall(SYS_pidfd_open, pid, 0);
+#else
+	return -1;
+#endif
+}
+
+// Anonymous file in memory, a temporary file if memfd is not available
+int Tools::memfdCreate(const char *name) {
+	int fd = -1;
+#if defined(SYS_memfd_create) && defined(MFD_CLOEXEC)
+	fd = syscall(SYS_memfd_create, name, MFD_CLOEXEC);
+#endif
+#ifdef O_TMPFILE
+	if (fd == -1) {
+		fd = open("/tmp", O_TMPFILE | O_RDWR | O_CLOEXEC, 0600);
+	}
+#endif
+	return fd;
+}
+
+// memfd with data, -1 if it can not be created or written
+int Tools::memfdWith(const char *name, const char *data, size_t size) {
+	int fd = memfdCreate(name);
+	if (fd == -1) {
+		return -1;
+	}
+	size_t written = 0;
+	while (written < size) {
+		ssize_t res = write(fd, data + written, size - written);
+		if (res < 0 && errno == EINTR) {
+			continue;
+		}
+		if (res <= 0) {
+			close(fd);
+			return -1;
+		}
+		written += res;
+	}
+	lseek(fd, 0, SEEK_SET);
+	return fd;
+}
+
+// Resources used until now by a running process, from /proc
+bool Tools::procUsage(pid_t pid, struct rusage &usage) {
+	memset(&usage, 0, sizeof(usage));
+	string stat = readFile("/proc/" + to_string(pid) + "/stat");
+	size_t pos = stat.rfind(')'); // The name of the program may contain spaces
+	if (pos == string::npos) {
+		return false;
+	}
+	unsigned long minflt, majflt, utime, stime;
+	if (sscanf(stat.c_str() + pos + 1, " %*c %*d %*d %*d %*d %*d %*u %lu %*u %lu %*u %lu %lu",
+			&minflt, &majflt, &utime, &stime) != 4) {
+		return false;
+	}
+	long ticks = sysconf(_SC_CLK_TCK);
+	usage.ru_minflt = minflt;
+	usage.ru_majflt = majflt;
+	usage.ru_utime.tv_sec = utime / ticks;
+	usage.ru_utime.tv_usec = (utime % ticks) * 1000000 / ticks;
+	usage.ru_stime.tv_sec = stime / ticks;
+	usage.ru_stime.tv_usec = (stime % ticks) * 1000000 / ticks;
+	vector<string> lines = splitLines(readFile("/proc/" + to_string(pid) + "/status"));
+	for (size_t i = 0; i < lines.size(); i++) {
+		sscanf(lines[i].c_str(), "VmHWM: %ld", &usage.ru_maxrss);
+		sscanf(lines[i].c_str(), "voluntary_ctxt_switches: %ld", &usage.ru_nvcsw);
+		sscanf(lines[i].c_str(), "nonvoluntary_ctxt_switches: %ld", &usage.ru_nivcsw);
+	}
+	return true;
+}
+
+// Resources used since before, the maximum RSS is kept
+void Tools::subUsage(struct rusage &usage, const struct rusage &before) {
+	timersub(&usage.ru_utime, &before.ru_utime, &usage.ru_utime);
+	timersub(&usage.ru_stime, &before.ru_stime, &usage.ru_stime);
+	usage.ru_minflt -= before.ru_minflt;
+	usage.ru_majflt -= before.ru_majflt;
+	usage.ru_nvcsw -= before.ru_nvcsw;
+	usage.ru_nivcsw -= before.ru_nivcsw;
+}
+
+double Tools::seconds(const struct timeval &tv) {
+	return tv.tv_sec + tv.tv_usec / 1e6;
+}
+
+// Ends the processes of a group: SIGTERM, SIGKILL 50ms later, and reaps them.
+// The evaluator is subreaper: orphans of the group become its children.
+// Returns the number of processes reaped other than the leader.
+int Tools::endProcessGroup(pid_t pgid, struct rusage &usage, bool &leaderReaped) {
+	const double grace = 0.05;
+	int strays = 0;
+	int signal = SIGTERM;
+	double deadline = Timer::now() + grace;
+	leaderReaped = false;
+	if (kill(-pgid, SIGTERM) != 0 && errno == ESRCH) {
+		return 0;
+	}
+	while (true) {
+		struct rusage processUsage;
+		pid_t pid = wait4(-pgid, NULL, WNOHANG, &processUsage);
+		if (pid > 0) {
+			if (pid == pgid) {
+				usage = processUsage;
+				leaderReaped = true;
+			} else {
+				strays++;
+			}
+			continue;
+		}
+		if (pid == -1 && errno == ECHILD && kill(-pgid, 0) != 0) {
+			break; // No process left
+		}
+		if (Timer::now() >= deadline) {
+			if (signal == SIGKILL) {
+				break; // Not killable, uninterruptible sleep
+			}
+			signal = SIGKILL;
+			kill(-pgid, SIGKILL);
+			deadline = Timer::now() + 1;
+		}
+		usleep(1000);
+	}
+	return strays;
+}
+
+// Kills and reaps the children left, orphans that changed their process group.
+// Only safe when no program is running. Returns the number of processes reaped.
+int Tools::endChildren() {
+	int count = 0;
+	pid_t self = getpid();
+	DIR *dir = opendir("/proc");
+	if (dir == NULL) {
+		return 0;
+	}
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		pid_t pid = atoi(entry->d_name);
+		if (pid <= 0) {
+			continue;
+		}
+		string stat = readFile("/proc/" + string(entry->d_name) + "/stat");
+		size_t pos = stat.rfind(')');
+		pid_t ppid;
+		if (pos != string::npos && sscanf(stat.c_str() + pos + 1, " %*c %d", &ppid) == 1
+				&& ppid == self) {
+			kill(pid, SIGKILL);
+			if (waitpid(pid, NULL, 0) == pid) {
+				count++;
+			}
+		}
+	}
+	closedir(dir);
+	return count;
+}
+
+// Processes and threads of the real user, those RLIMIT_NPROC counts
+rlim_t Tools::userTasks() {
+	rlim_t count = 0;
+	uid_t uid = getuid();
+	DIR *dir = opendir("/proc");
+	if (dir == NULL) {
+		return 0;
+	}
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL) {
+		if (atoi(entry->d_name) <= 0) {
+			continue;
+		}
+		vector<string> lines = splitLines(readFile("/proc/" + string(entry->d_name) + "/status"));
+		bool user = false;
+		for (size_t i = 0; i < lines.size(); i++) {
+			unsigned long value;
+			if (sscanf(lines[i].c_str(), "Uid: %lu", &value) == 1) {
+				user = value == uid;
+			} else if (user && sscanf(lines[i].c_str(), "Threads: %lu", &value) == 1) {
+				count += value;
+			}
+		}
+	}
+	closedir(dir);
+	return count;
+}
+
+// A size in bytes with optional suffix K, M or G (also KB, MB or GB)
+bool Tools::convert2Size(const string& str, double &data){
+	string value = toLower(trim(str));
+	double unit = 1;
+	if (value.size() > 1 && value[value.size() - 1] == 'b') {
+		value.resize(value.size() - 1);
+	}
+	if (value.size() > 1) {
+		switch (value[value.size() - 1]) {
+		case 'k': unit = 1024; break;
+		case 'm': unit = 1024 * 1024; break;
+		case 'g': unit = 1024 * 1024 * 1024; break;
+		}
+		if (unit > 1) {
+			value.resize(value.size() - 1);
+		}
+	}
+	value = trim(value);
+	if (value.size() == 0 || ! convert2(value, data) || data < 0) {
+		return false;
+	}
+	data *= unit;
+	return true;
+}
+
 bool Tools::convert2(const string& str, double &data){
 	if ( str == "." ){
 		return false;
 	}
+	if ( parseNumber(str, data) ){
+		return true;
+	}
 	stringstream conv(str);
 	conv >> data;
 	return conv.eof();
 }
 
 bool Tools::convert2(const string& str, long int &data){
+	bool valid;
+	if ( parseNumber(str, data, valid) ){
+		return valid;
+	}
 	stringstream conv(str);
 	conv >> data;
 	return conv.eof();
 }
+
+// Converts [+-]digits[.digits][e[+-]digits] without a stream, as convert2 does.
+// False if str has another form or is out of range, convert2 uses a stream then
+VPL_OPTIMIZE
+bool Tools::parseNumber(const string& str, double &data){
+	const char *s = str.data();
+	size_t n = str.size(), i = 0, digits = 0;
+	if (i < n && (s[i] == '+' || s[i] == '-')) i++;
+	for (; i < n && s[i] >= '0' && s[i] <= '9'; i++) digits++;
+	if (i < n && s[i] == '.') {
+		for (i++; i < n && s[i] >= '0' && s[i] <= '9'; i++) digits++;
+	}
+	if (digits == 0) return false;
+	if (i < n && (s[i] == 'e' || s[i] == 'E')) {
+		i++;
+		if (i < n && (s[i] == '+' || s[i] == '-')) i++;
+		size_t exponent = i;
+		for (; i < n && s[i] >= '0' && s[i] <= '9'; i++);
+		if (i == exponent) return false;
+	}
+	if (i != n) return false;
+	const char *start = s[0] == '+' ? s + 1 : s; // from_chars does not take '+'
+	double value;
+	from_chars_result result = from_chars(start, s + n, value);
+	if (result.ec != errc() || result.ptr != s + n) return false;
+	data = value;
+	return true;
+}
+
+// Converts [+-]digits without a stream, as convert2 does. Also knows that [+-]digits followed
+// by other chars is not valid. False if str has another form or overflows, convert2 uses a stream then
+VPL_OPTIMIZE
+bool Tools::parseNumber(const string& str, long int &data, bool &valid){
+	const char *s = str.data();
+	size_t n = str.size();
+	const char *start = n > 0 && s[0] == '+' ? s + 1 : s; // from_chars does not take '+'
+	const char *digit = n > 0 && s[0] == '-' ? s + 1 : start;
+	if (digit == s + n || *digit < '0' || *digit > '9') {
+		return false;
+	}
+	long int value;
+	from_chars_result result = from_chars(start, s + n, value);
+	if (result.ec != errc()) return false;
+	valid = result.ptr == s + n; // A stream would also stop before the end
+	if (valid) data = value;
+	return true;
+}
 const char* Tools::getenv(const char* name, const char* defaultvalue) {
 	const char* value = ::getenv(name);
 	if ( value == NULL ) {
@@ -1357,6 +2256,21 @@ double Tools::getenv(const char* name, double defaultvalue) {
 	return value;
 }
 
+// Optional settings: no warning if not defined
+double Tools::getenvOption(const char* name, double defaultvalue) {
+	const char* svalue = ::getenv(name);
+	double value;
+	if ( svalue != NULL && Tools::convert2(svalue, value) ) {
+		return value;
+	}
+	return defaultvalue;
+}
+
+const char* Tools::getenvOption(const char* name, const char* defaultvalue) {
+	const char* value = ::getenv(name);
+	return value == NULL ? defaultvalue : value;
+}
+
 
 /**
  * Class Stop Definitions
@@ -1374,12 +2288,19 @@ bool Stop::isTERMRequested() {
  * Class Timer Definitions
  */
 
+// Monotonic clock in seconds, with sub-second resolution
+double Timer::now() {
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
 void Timer::start() {
-	startTime = time(NULL);
+	startTime = now();
 }
 
-int Timer::elapsedTime() {
-	return time(NULL) - startTime;
+double Timer::elapsedTime() {
+	return now() - startTime;
 }
 
 /**
@@ -1395,32 +2316,180 @@ const char *I18n::get_string(const char *s){
 }
 
 /**
- * Class NumbersOutput Definitions
+ * Interface OutputChecker Definitions
  */
 
-// Struct Number
-bool NumbersOutput::Number::set(const string& str){
-	isInteger=Tools::convert2(str, integer);
-	if(!isInteger){
-		return Tools::convert2(str, cientific);
+bool OutputChecker::matchParsed(ParsedOutput &output){
+	return match(output.getText());
+}
+
+/**
+ * Class ParsedOutput Definitions
+ */
+
+ParsedOutput::ParsedOutput(const string &first, const string &second):first(first),second(second){
+	textBuilt = false;
+	numbersBuilt = false;
+	wordsBuilt = false;
+}
+
+const string &ParsedOutput::getText(){
+	if (second.size() == 0) {
+		return first;
 	}
-	return true;
+	if (! textBuilt) {
+		text.reserve(first.size() + second.size());
+		text = first;
+		text += second;
+		textBuilt = true;
+	}
+	return text;
 }
 
-bool NumbersOutput::Number::operator==(const Number &o)const{
-	if(isInteger)
-		return o.isInteger && integer == o.integer;
-	if(o.isInteger)
-		return cientific != 0?fabs((cientific - o.integer) / cientific) < 0.0001 : o.integer == 0;
-	else
-		return cientific != 0?fabs((cientific - o.cientific) / cientific) < 0.0001 : fabs(o.cientific) < 0.0001;
+// Numbers and words are split through the parts, without joining them
+const vector<NumbersOutput::Number> &ParsedOutput::getNumbers(){
+	if (! numbersBuilt) {
+		string str;
+		NumbersOutput::parse(first.data(), first.size(), str, numbers);
+		NumbersOutput::parse(second.data(), second.size(), str, numbers);
+		NumbersOutput::parseEnd(str, numbers);
+		numbersBuilt = true;
+	}
+	return numbers;
 }
 
-bool NumbersOutput::Number::operator!=(const Number &o)const{
-	return !((*this)==o);
+const vector<string_view> &ParsedOutput::getWords(){
+	if (! wordsBuilt) {
+		folded.reserve(first.size() + second.size());
+		TextOutput::fold(first.data(), first.size(), folded);
+		TextOutput::fold(second.data(), second.size(), folded);
+		TextOutput::split(folded, words);
+		wordsBuilt = true;
+	}
+	return words;
 }
 
-NumbersOutput::Number::operator string() const{
+/**
+ * Class NumberScanner Definitions
+ */
+
+int NumberScanner::level = -1;
+
+void NumberScanner::init(){
+	level = 0;
+#ifdef VPL_X86_SIMD
+	level = __builtin_cpu_supports("avx2") ? 2 : 1;
+#endif
+}
+
+bool NumberScanner::isNum(char c){
+	return isNumStart(c) || c=='e' || c=='E';
+}
+
+bool NumberScanner::isNumStart(char c){
+	return (c>='0' && c<='9') || c=='+' || c=='-' || c=='.';
+}
+
+// First position from "from" with a number start char (start) or a not number char, size if none
+VPL_OPTIMIZE
+size_t NumberScanner::findScalar(const char *data, size_t from, size_t size, bool start){
+	for(; from < size; from++){
+		char c = data[from];
+		bool numStart = (c>='0' && c<='9') || c=='+' || c=='-' || c=='.';
+		if(start ? numStart : ! (numStart || c=='e' || c=='E')) break;
+	}
+	return from;
+}
+
+#ifdef VPL_X86_SIMD
+// Same as findScalar, 16 chars at once
+VPL_OPTIMIZE
+size_t NumberScanner::findSSE2(const char *data, size_t from, size_t size, bool start){
+	const __m128i beforeZero = _mm_set1_epi8('0' - 1), afterNine = _mm_set1_epi8('9' + 1);
+	const __m128i plus = _mm_set1_epi8('+'), minus = _mm_set1_epi8('-'), dot = _mm_set1_epi8('.');
+	const __m128i e = _mm_set1_epi8('e'), E = _mm_set1_epi8('E');
+	for(; from + 16 <= size; from += 16){
+		__m128i v = _mm_loadu_si128((const __m128i *) (data + from));
+		__m128i found = _mm_and_si128(_mm_cmpgt_epi8(v, beforeZero), _mm_cmplt_epi8(v, afterNine));
+		found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(v, plus),
+				_mm_or_si128(_mm_cmpeq_epi8(v, minus), _mm_cmpeq_epi8(v, dot))));
+		if(! start){
+			found = _mm_or_si128(found, _mm_or_si128(_mm_cmpeq_epi8(v, e), _mm_cmpeq_epi8(v, E)));
+		}
+		unsigned mask = _mm_movemask_epi8(found);
+		if(! start) mask = ~mask & 0xFFFF;
+		if(mask) return from + __builtin_ctz(mask);
+	}
+	return findScalar(data, from, size, start);
+}
+
+// Same as findScalar, 32 chars at once
+VPL_OPTIMIZE __attribute__((target("avx2")))
+size_t NumberScanner::findAVX2(const char *data, size_t from, size_t size, bool start){
+	const __m256i beforeZero = _mm256_set1_epi8('0' - 1), afterNine = _mm256_set1_epi8('9' + 1);
+	const __m256i plus = _mm256_set1_epi8('+'), minus = _mm256_set1_epi8('-'), dot = _mm256_set1_epi8('.');
+	const __m256i e = _mm256_set1_epi8('e'), E = _mm256_set1_epi8('E');
+	for(; from + 32 <= size; from += 32){
+		__m256i v = _mm256_loadu_si256((const __m256i *) (data + from));
+		__m256i found = _mm256_and_si256(_mm256_cmpgt_epi8(v, beforeZero), _mm256_cmpgt_epi8(afterNine, v));
+		found = _mm256_or_si256(found, _mm256_or_si256(_mm256_cmpeq_epi8(v, plus),
+				_mm256_or_si256(_mm256_cmpeq_epi8(v, minus), _mm256_cmpeq_epi8(v, dot))));
+		if(! start){
+			found = _mm256_or_si256(found, _mm256_or_si256(_mm256_cmpeq_epi8(v, e), _mm256_cmpeq_epi8(v, E)));
+		}
+		unsigned mask = _mm256_movemask_epi8(found);
+		if(! start) mask = ~mask;
+		if(mask) return from + __builtin_ctz(mask);
+	}
+	return findSSE2(data, from, size, start);
+}
+#endif
+
+// First position from "from" where a number may start, size if none
+size_t NumberScanner::findStart(const char *data, size_t from, size_t size){
+#ifdef VPL_X86_SIMD
+	if(level == 2) return findAVX2(data, from, size, true);
+	if(level == 1) return findSSE2(data, from, size, true);
+#endif
+	return findScalar(data, from, size, true);
+}
+
+// First position from "from" that can not be part of a number, size if none
+size_t NumberScanner::findEnd(const char *data, size_t from, size_t size){
+#ifdef VPL_X86_SIMD
+	if(level == 2) return findAVX2(data, from, size, false);
+	if(level == 1) return findSSE2(data, from, size, false);
+#endif
+	return findScalar(data, from, size, false);
+}
+
+/**
+ * Class NumbersOutput Definitions
+ */
+
+// Struct Number
+bool NumbersOutput::Number::set(const string& str){
+	isInteger=Tools::convert2(str, integer);
+	if(!isInteger){
+		return Tools::convert2(str, cientific);
+	}
+	return true;
+}
+
+bool NumbersOutput::Number::operator==(const Number &o)const{
+	if(isInteger)
+		return o.isInteger && integer == o.integer;
+	if(o.isInteger)
+		return cientific != 0?fabs((cientific - o.integer) / cientific) < 0.0001 : o.integer == 0;
+	else
+		return cientific != 0?fabs((cientific - o.cientific) / cientific) < 0.0001 : fabs(o.cientific) < 0.0001;
+}
+
+bool NumbersOutput::Number::operator!=(const Number &o)const{
+	return !((*this)==o);
+}
+
+NumbersOutput::Number::operator string() const{
 	char buf[100];
 	if(isInteger) {
 		sprintf(buf, "%ld", integer);
@@ -1432,13 +2501,11 @@ NumbersOutput::Number::operator string() const{
 
 
 bool NumbersOutput::isNum(char c){
-	if(isdigit(c)) return true;
-	return c=='+' || c=='-' || c=='.' || c=='e' || c=='E';
+	return NumberScanner::isNum(c);
 }
 
 bool NumbersOutput::isNumStart(char c){
-	if(isdigit(c)) return true;
-	return c=='+' || c=='-' || c=='.';
+	return NumberScanner::isNumStart(c);
 }
 
 bool NumbersOutput::calcStartWithAsterisk(){
@@ -1457,22 +2524,39 @@ bool NumbersOutput::calcStartWithAsterisk(){
 	return false;
 }
 
-NumbersOutput::NumbersOutput(const string &text):OutputChecker(text){
-	int l=text.size();
-	string str;
+// Adds the numbers of data, the last one may continue in the next data (str).
+// The char that ends a number is not part of the next one
+void NumbersOutput::parse(const char *data, size_t size, string &str, vector<Number> &numbers){
 	Number number;
-	for(int i=0; i<l; i++){
-		char c=text[i];
-		if((isNum(c) && str.size()>0) || (isNumStart(c) && str.size()==0)){
-			str+=c;
-		}else if(str.size()>0){
-			if(isNumStart(str[0]) && number.set(str)) numbers.push_back(number);
-			str="";
+	size_t i = 0;
+	while(i < size){
+		size_t from = i;
+		if(str.size() == 0){
+			i = NumberScanner::findStart(data, i, size);
+			if(i == size) break;
+			from = i + 1;
 		}
+		size_t end = NumberScanner::findEnd(data, from, size);
+		str.append(data + i, end - i);
+		if(end == size) break;
+		if(isNumStart(str[0]) && number.set(str)) numbers.push_back(number);
+		str.clear();
+		i = end + 1;
 	}
+}
+
+void NumbersOutput::parseEnd(string &str, vector<Number> &numbers){
+	Number number;
 	if(str.size()>0){
 		if(isNumStart(str[0]) && number.set(str)) numbers.push_back(number);
+		str="";
 	}
+}
+
+NumbersOutput::NumbersOutput(const string &text):OutputChecker(text){
+	string str;
+	parse(text.data(), text.size(), str, numbers);
+	parseEnd(str, numbers);
 	startWithAsterisk=calcStartWithAsterisk();
 }
 
@@ -1480,21 +2564,63 @@ string NumbersOutput::studentOutputExpected(){
 	return cleanText;
 }
 
-bool NumbersOutput::operator==(const NumbersOutput& o)const{
+// Integers are compared in place, the others with the tolerance of Number
+VPL_OPTIMIZE
+bool NumbersOutput::matchNumbers(const vector<Number> &output)const{
 	size_t l=numbers.size();
-	if( o.numbers.size() < l ) return false;
+	if( output.size() < l ) return false;
 	int offset = 0;
 	if(startWithAsterisk)
-		offset = o.numbers.size()-l;
-	for(size_t i = 0; i < l; i++)
-		if(numbers[i] != o.numbers[offset+i])
+		offset = output.size()-l;
+	const Number *expected = numbers.data();
+	const Number *found = output.data() + offset;
+	for(size_t i = 0; i < l; i++){
+		if(expected[i].isInteger && found[i].isInteger){
+			if(expected[i].integer != found[i].integer) return false;
+		}else if(expected[i] != found[i]){
 			return false;
+		}
+	}
 	return true;
 }
 
+bool NumbersOutput::operator==(const NumbersOutput& o)const{
+	return matchNumbers(o.numbers);
+}
+
 bool NumbersOutput::match(const string& output){
-	NumbersOutput temp(output);
-	return operator==(temp);
+	vector<Number> outputNumbers;
+	string str;
+	parse(output.data(), output.size(), str, outputNumbers);
+	parseEnd(str, outputNumbers);
+	return matchNumbers(outputNumbers);
+}
+
+bool NumbersOutput::matchParsed(ParsedOutput &output){
+	return matchNumbers(output.getNumbers());
+}
+
+// Numbers compared from the end (*) are only known at the end of the output
+OutputStreamChecker* NumbersOutput::streamChecker(){
+	return startWithAsterisk ? NULL : new StreamChecker(numbers);
+}
+
+// Splits the output as the constructor does, the last number may continue in the next data
+bool NumbersOutput::StreamChecker::add(const char *data, size_t size){
+	Number number;
+	for(size_t i = 0; i < size && found < numbers.size(); i++){
+		char c = data[i];
+		if((isNum(c) && str.size()>0) || (isNumStart(c) && str.size()==0)){
+			str += c;
+		}else if(str.size()>0){
+			if(isNumStart(str[0]) && number.set(str)){
+				if(numbers[found] != number) return false;
+				found++;
+			}
+			str = "";
+		}
+	}
+	return true;
 }
 
 OutputChecker* NumbersOutput::clone(){
@@ -1541,41 +2667,67 @@ NumbersOutput::operator string () const{
  * Class TextOutput Definitions
  */
 
+VPL_OPTIMIZE
 bool TextOutput::isAlpha(char c){
 	if ( isalnum(c) ) return true;
 	return c < 0;
 }
 
-TextOutput::TextOutput(const string &text):OutputChecker(text){
-	size_t l = text.size();
-	string token;
-	for(size_t i = 0; i < l; i++){
-		char c = text[i];
-		if( isAlpha(c) ){
-			token += c;
-		}else if(token.size() > 0){
-			tokens.push_back(Tools::toLower(token));
-			token="";
-		}
+// Appends data in lowercase
+VPL_OPTIMIZE
+void TextOutput::fold(const char *data, size_t size, string &folded){
+	size_t start = folded.size();
+	folded.append(data, size);
+	for(size_t i = start; i < folded.size(); i++){
+		folded[i] = tolower(folded[i]);
 	}
-	if(token.size()>0){
-		tokens.push_back(Tools::toLower(token));
+}
+
+// Adds the words of a lowercase text, they point to the text
+VPL_OPTIMIZE
+void TextOutput::split(const string &folded, vector<string_view> &tokens){
+	const char *data = folded.data();
+	size_t size = folded.size();
+	size_t i = 0;
+	while(i < size){
+		while(i < size && ! isAlpha(data[i])) i++;
+		size_t start = i;
+		while(i < size && isAlpha(data[i])) i++;
+		if(i > start){
+			tokens.push_back(string_view(data + start, i - start));
+		}
 	}
 }
 
-bool TextOutput::operator==(const TextOutput& o) {
+TextOutput::TextOutput(const string &text):OutputChecker(text){
+	fold(text.data(), text.size(), folded);
+	split(folded, tokens);
+}
+
+bool TextOutput::matchTokens(const vector<string_view> &output) {
 	size_t l = tokens.size();
-	if (o.tokens.size() < l) return false;
-	int offset = o.tokens.size() - l;
+	if (output.size() < l) return false;
+	int offset = output.size() - l;
 	for (size_t i = 0; i < l; i++)
-		if (tokens[i] != o.tokens[ offset + i ])
+		if (tokens[i] != output[ offset + i ])
 			return false;
 	return true;
 }
 
+bool TextOutput::operator==(const TextOutput& o) {
+	return matchTokens(o.tokens);
+}
+
 bool TextOutput::match(const string& output) {
-	TextOutput temp(output);
-	return operator== (temp);
+	string outputFolded;
+	vector<string_view> outputTokens;
+	fold(output.data(), output.size(), outputFolded);
+	split(outputFolded, outputTokens);
+	return matchTokens(outputTokens);
+}
+
+bool TextOutput::matchParsed(ParsedOutput &output) {
+	return matchTokens(output.getWords());
 }
 
 OutputChecker* TextOutput::clone() {
@@ -1620,19 +2772,35 @@ bool ExactTextOutput::operator==(const ExactTextOutput& o){
 
 bool ExactTextOutput::match(const string& output){
 	if (cleanText == output) return true;
-	string cleanOutput = output;
-	// Removes last output char if is a newline and the last searched char is not a newline.
+	size_t size = output.size();
+	// Ignores the last output char if is a newline and the last searched char is not a newline.
 	if (cleanText.size() > 0 && cleanText[cleanText.size()-1] != '\n' ) {
-		if (cleanOutput.size() > 0 && cleanOutput[cleanOutput.size()-1] == '\n' ) {
-			cleanOutput = cleanOutput.substr(0, cleanOutput.size()-1);
+		if (size > 0 && output[size-1] == '\n' ) {
+			size--;
 		}
 	}
-	if (startWithAsterix && cleanText.size() < cleanOutput.size()) {
-		size_t start = cleanOutput.size() - cleanText.size();
-		return cleanText == cleanOutput.substr(start, cleanText.size());
+	if (startWithAsterix && cleanText.size() < size) {
+		return output.compare(size - cleanText.size(), cleanText.size(), cleanText) == 0;
 	} else {
-		return cleanText == cleanOutput;
+		return output.compare(0, size, cleanText) == 0;
+	}
+}
+
+// Texts compared with the end of the output (*) are only known at the end
+OutputStreamChecker* ExactTextOutput::streamChecker(){
+	return startWithAsterix ? NULL : new StreamChecker(cleanText);
+}
+
+// The output must be the text, or the text and a newline if the text does not end with one
+bool ExactTextOutput::StreamChecker::add(const char *data, size_t size){
+	bool newlineAllowed = text.size() > 0 && text[text.size() - 1] != '\n';
+	for(size_t i = 0; i < size; i++, found++){
+		if(found < text.size() ? data[i] != text[found]
+				: found > text.size() || ! newlineAllowed || data[i] != '\n'){
+			return false;
+		}
 	}
+	return true;
 }
 
 OutputChecker* ExactTextOutput::clone(){
@@ -1649,6 +2817,43 @@ string ExactTextOutput::type(){
 	return (L->langEvaluate(5)).c_str();
 }
 
+/**
+ * Class PosixRegex Definitions
+ */
+
+// NULL if the expression is not valid, error has the reason
+PosixRegex* PosixRegex::compile(const string &pattern, int flags, string &error) {
+	PosixRegex *regex = new PosixRegex();
+	int reti = regcomp(&regex->expression, pattern.c_str(), flags);
+	if (reti != 0) {
+		char buf[500];
+		regerror(reti, &regex->expression, buf, sizeof(buf));
+		error = buf;
+		delete regex;
+		return NULL;
+	}
+	regex->compiled = true;
+	return regex;
+}
+
+PosixRegex::~PosixRegex() {
+	if (compiled) {
+		regfree(&expression);
+	}
+}
+
+// Without REG_STARTEND the data must end with '\0', as string data does
+int PosixRegex::match(const char *data, size_t size) {
+#ifdef REG_STARTEND
+	regmatch_t range;
+	range.rm_so = 0;
+	range.rm_eo = size;
+	return regexec(&expression, data, 1, &range, REG_STARTEND);
+#else
+	return regexec(&expression, data, 0, NULL, 0);
+#endif
+}
+
 /**
  * Class RegularExpressionOutput Definitions
  */
@@ -1693,67 +2898,73 @@ RegularExpressionOutput::RegularExpressionOutput(const string &text, const strin
 			pos++;
 		}
 	}
+	// Compiled once, no submatches needed
+	int flags = REG_EXTENDED | REG_NOSUB | (flagM ? REG_NEWLINE : 0) | (flagI ? REG_ICASE : 0);
+	string error;
+	engine.reset(PosixRegex::compile(cleanText, flags, error));
+	if (! engine) {
+		fatalError(string((L->langEvaluate(7)).c_str()) + string((L->langEvaluate(8)).c_str())
+				+ string(errorCase) + string(".\n") + error);
+	}
+	if (! flagI) {
+		literal = requiredLiteral(cleanText);
+	}
 }
 
-// Regular Expression compilation (with flags in mind) and comparison with the input and output evaluation
-bool RegularExpressionOutput::match (const string& output) {
+// Stops the evaluation, the case can not be evaluated
+void RegularExpressionOutput::fatalError(const string &message) {
+	Evaluation* p_ErrorTest = Evaluation::getSinglenton();
+	p_ErrorTest->addFatalError(message.c_str());
+	p_ErrorTest->outputEvaluation();
+	abort();
+}
 
-	reti=-1;
-	const char * in = cleanText.c_str();
-	// Use POSIX-C regrex.h
-	// Flag compilation
-	if (flagI || flagM) {
-		if (flagM && flagI) {
-			reti = regcomp(&expression, in, REG_EXTENDED | REG_NEWLINE | REG_ICASE);
-		} else if (flagM) {
-			reti = regcomp(&expression, in, REG_EXTENDED | REG_NEWLINE);
-		} else {
-			reti = regcomp(&expression, in, REG_EXTENDED | REG_ICASE);
+// Literal text at the start of the expression, without the last char if it has a quantifier.
+// Any match contains it. "" if the expression has alternatives or starts with a special char
+string RegularExpressionOutput::requiredLiteral(const string &pattern) {
+	bool escaped = false;
+	for (size_t i = 0; i < pattern.size(); i++) {
+		if (escaped) {
+			escaped = false;
+		} else if (pattern[i] == '\\') {
+			escaped = true;
+		} else if (pattern[i] == '|') {
+			return "";
 		}
-
-	// No flag compilation
-	} else {
-		reti = regcomp(&expression, in, REG_EXTENDED);
 	}
+	const char *special = "\\^$.[]|()*+?{}";
+	size_t start = pattern.size() > 0 && pattern[0] == '^' ? 1 : 0;
+	size_t end = start;
+	while (end < pattern.size() && strchr(special, pattern[end]) == NULL) {
+		end++;
+	}
+	if (end < pattern.size() && strchr("*+?{", pattern[end]) != NULL && end > start) {
+		end--;
+	}
+	return pattern.substr(start, end - start);
+}
 
-	if (reti == 0) { // Compilation was successful
-
-		const char * out = output.c_str();
-		reti = regexec(&expression, out, 0, NULL, 0);
-
-		if (reti == 0) { // Match
-			return true;
-		} else if (reti == REG_NOMATCH){ // No match
-			return false;
-
-		} else { // Memory Error
-			Evaluation* p_ErrorTest = Evaluation::getSinglenton();
-			string errorType = string((L->langEvaluate(6)).c_str()) + string(errorCase);
-			const char* flagError = errorType.c_str();
-			p_ErrorTest->addFatalError(flagError);
-			p_ErrorTest->outputEvaluation();
-			abort();
-		}
-
-	} else { // Compilation error
-		size_t length = regerror(reti, &expression, NULL, 0);
-        char* bff = new char[length + 1];
-        (void) regerror(reti, &expression, bff, length);
-		Evaluation* p_ErrorTest = Evaluation::getSinglenton();
-		string errorType = string((L->langEvaluate(7)).c_str()) + string((L->langEvaluate(8)).c_str()) + string(errorCase) + string(".\n")+ string(bff);
-		const char* flagError = errorType.c_str();
-		p_ErrorTest->addFatalError(flagError);
-		p_ErrorTest->outputEvaluation();
-		abort();
+// Regular Expression comparison with the output, compiled by the constructor
+bool RegularExpressionOutput::match (const string& output) {
+	if (literal.size() && memmem(output.data(), output.size(), literal.data(), literal.size()) == NULL) {
+		return false;
+	}
+	int reti = engine->match(output.data(), output.size());
+	if (reti == 0) { // Match
+		return true;
+	} else if (reti == REG_NOMATCH){ // No match
 		return false;
 	}
+	// Memory Error
+	fatalError(string((L->langEvaluate(6)).c_str()) + string(errorCase));
+	return false;
 }
 
 // Returns the expression without flags nor '/'
 string RegularExpressionOutput::studentOutputExpected() {return cleanText;}
 
 OutputChecker* RegularExpressionOutput::clone() {
-	return new RegularExpressionOutput(outputExpected(), errorCase);
+	return new RegularExpressionOutput(*this);
 }
 
 // Tests if it's a regular expression. A regular expressions should be between /../
@@ -1773,143 +2984,985 @@ string RegularExpressionOutput::type() {
 	return (L->langEvaluate(9)).c_str();
 }
 /**
- * Class Case Definitions
- * Case represents cases
+ * Class CheckerOutput Definitions
  */
-Case::Case() {
-	reset();
+
+CheckerOutput::CheckerOutput(const string &command, const string &expected, const string &input,
+		const string &inputFile):OutputChecker(expected) {
+	istringstream words(command);
+	string word;
+	while (words >> word) {
+		args.push_back(word);
+	}
+	this->input = input;
+	this->inputFile = inputFile;
+	timeLimit = CHECKERTIMEOUT;
 }
 
-void Case::reset() {
-	input = "";
-	output.clear();
-	caseDescription = "";
-	gradeReduction = std::numeric_limits<float>::min();
-	failMessage = "";
-	programToRun = "";
-	programArgs = "";
-	variation = "";
-	expectedExitCode = std::numeric_limits<int>::min();
+void CheckerOutput::setTimeLimit(double timeLimit) {
+	this->timeLimit = timeLimit;
 }
 
-void Case::addInput(string s) {
-	input += s;
+// Gives the input, the expected output and the output as memfds, the input file as it is
+bool CheckerOutput::match(const string& output) {
+	message = "";
+	int fds[3];
+	if (inputFile.size()) {
+		fds[0] = open(inputFile.c_str(), O_RDONLY | O_CLOEXEC);
+	} else {
+		fds[0] = Tools::memfdWith("input", input.data(), input.size());
+	}
+	fds[1] = Tools::memfdWith("expected", text.data(), text.size());
+	fds[2] = Tools::memfdWith("output", output.data(), output.size());
+	bool correct = false;
+	if (fds[0] == -1 || fds[1] == -1 || fds[2] == -1) {
+		char buf[250];
+		sprintf(buf, (L->langEvaluate(60)).c_str(), strerror(errno));
+		message = buf;
+	} else {
+		correct = run(fds);
+	}
+	for (int i = 0; i < 3; i++) {
+		if (fds[i] != -1) {
+			close(fds[i]);
+		}
+	}
+	return correct;
 }
 
-string Case::getInput() {
-	return input;
+// Runs the checker, reading what it writes until it ends or its time limit
+bool CheckerOutput::run(const int fds[3]) {
+	char buf[250];
+	if (args.size() == 0) {
+		return false;
+	}
+	vector<string> argStrings = args;
+	for (int i = 0; i < 3; i++) {
+		argStrings.push_back("/proc/self/fd/" + to_string(3 + i));
+	}
+	vector<const char *> argv;
+	for (const string &arg : argStrings) {
+		argv.push_back(arg.c_str());
+	}
+	argv.push_back(NULL);
+	int pp[2];
+	int fdnull = open("/dev/null", O_RDONLY | O_CLOEXEC);
+	if (fdnull == -1 || pipe2(pp, O_CLOEXEC) == -1) {
+		sprintf(buf, (L->langEvaluate(60)).c_str(), strerror(errno));
+		message = buf;
+		if (fdnull != -1) {
+			close(fdnull);
+		}
+		return false;
+	}
+	CaseLimits limits;
+	ProcessLauncher launcher(argv[0], argv.data(), (const char **) environ, fdnull, pp[1], limits);
+	launcher.setExtraFds(fds, 3);
+	pid_t pid = launcher.launch();
+	close(fdnull);
+	close(pp[1]);
+	if (pid == -1) {
+		sprintf(buf, (L->langEvaluate(60)).c_str(),
+				strerror(launcher.getExecError() ? launcher.getExecError() : errno));
+		message = buf;
+		close(pp[0]);
+		return false;
+	}
+	// Reads until the checker ends, its processes may keep the pipe open
+	double deadline = Timer::now() + timeLimit;
+	bool readable = true, ended = false, killed = false;
+	char data[4096];
+	while (! ended) {
+		if (! killed && Timer::now() >= deadline) {
+			kill(-pid, SIGKILL);
+			killed = true;
+		}
+		if (readable) {
+			struct pollfd device = {pp[0], POLLIN, 0};
+			if (poll(&device, 1, 10) > 0) {
+				ssize_t readed = read(pp[0], data, sizeof(data));
+				if (readed > 0) {
+					addMessage(data, readed);
+					continue;
+				}
+				readable = readed < 0 && errno == EINTR;
+			}
+		} else {
+			usleep(1000);
+		}
+		siginfo_t info;
+		info.si_pid = 0; // Ended but not reaped, its group still exists
+		int res = waitid(P_PID, pid, &info, WEXITED | WNOWAIT | WNOHANG);
+		ended = (res == -1 && errno != EINTR) || (res == 0 && info.si_pid == pid);
+	}
+	struct pollfd device = {pp[0], POLLIN, 0};
+	while (readable && poll(&device, 1, 0) > 0) {
+		ssize_t readed = read(pp[0], data, sizeof(data));
+		if (readed <= 0) {
+			break;
+		}
+		addMessage(data, readed);
+	}
+	close(pp[0]);
+	// Processes left by the checker
+	kill(-pid, SIGKILL);
+	int status = 0;
+	pid_t reaped;
+	while ((reaped = waitpid(pid, &status, 0)) == -1 && errno == EINTR);
+	if (reaped == pid && WIFEXITED(status)) {
+		return WEXITSTATUS(status) == 0;
+	}
+	if (message.size() && message[message.size() - 1] != '\n') {
+		message += '\n';
+	}
+	sprintf(buf, (L->langEvaluate(60)).c_str(),
+			reaped == pid && WIFSIGNALED(status) ? strsignal(WTERMSIG(status)) : strerror(errno));
+	message += buf;
+	return false;
 }
 
-void Case::addOutput(string o) {
-	output.push_back(o);
+// Up to COMMENTSECTIONSIZE, the rest is discarded
+void CheckerOutput::addMessage(const char *data, size_t size) {
+	if (message.size() < (size_t) COMMENTSECTIONSIZE) {
+		message.append(data, min(size, COMMENTSECTIONSIZE - message.size()));
+	}
 }
 
-const vector< string > & Case::getOutput() {
-	return output;
+string CheckerOutput::getMessage() {
+	return message;
 }
 
-void Case::setFailMessage(const string &s) {
-	failMessage = s;
+OutputChecker* CheckerOutput::clone() {
+	return new CheckerOutput(*this);
 }
 
-string Case::getFailMessage() {
-	return failMessage;
+string CheckerOutput::type() {
+	return (L->langEvaluate(59)).c_str();
 }
-void Case::setCaseDescription(const string &s) {
-	caseDescription = s;
+
+/**
+ * Class CaseLimits Definitions
+ */
+
+CaseLimits::CaseLimits() {
+	memory = 0;
+	cputime = 0;
+	filesize = 0;
+	processes = 0;
+	output = 0;
 }
 
-string Case::getCaseDescription() {
-	return caseDescription;
+bool CaseLimits::operator==(const CaseLimits &o) const {
+	return memory == o.memory && cputime == o.cputime && filesize == o.filesize
+			&& processes == o.processes && output == o.output;
 }
-void Case::setGradeReduction(float g) {
-	gradeReduction = g;
+
+/**
+ * Class OutputBuffer Definitions
+ */
+
+OutputBuffer::OutputBuffer() {
+	capacity = MAXOUTPUT;
+	clear();
 }
 
-float Case::getGradeReduction() {
-	return gradeReduction;
+void OutputBuffer::setCapacity(size_t capacity) {
+	this->capacity = max(capacity, (size_t) 2);
+	clear();
 }
 
-void Case::setExpectedExitCode(int e) {
-	expectedExitCode = e;
+size_t OutputBuffer::getCapacity() const {
+	return capacity;
 }
 
-int Case::getExpectedExitCode() {
-	return expectedExitCode;
+void OutputBuffer::clear() {
+	total = 0;
+	data.clear();
+	tail.clear();
+	tailPos = 0;
+	joined.clear();
+	joinedValid = false;
 }
-void Case::setProgramToRun(const string &s) {
-	programToRun = s;
+
+void OutputBuffer::appendTail(const char *buf, size_t size) {
+	if (size >= tail.size()) {
+		memcpy(&tail[0], buf + size - tail.size(), tail.size());
+		tailPos = 0;
+		return;
+	}
+	size_t first = min(size, tail.size() - tailPos);
+	memcpy(&tail[tailPos], buf, first);
+	memcpy(&tail[0], buf + first, size - first);
+	tailPos = (tailPos + size) % tail.size();
 }
 
-string Case::getProgramToRun() {
-	return programToRun;
+void OutputBuffer::append(const char *buf, size_t size) {
+	total += size;
+	joinedValid = false;
+	if (tail.size()) {
+		appendTail(buf, size);
+	} else if (data.size() + size <= capacity) {
+		data.append(buf, size);
+	} else { // Keeps the first half and the last half from now on
+		size_t headSize = capacity / 2;
+		if (data.size() < headSize) {
+			size_t fill = headSize - data.size();
+			data.append(buf, fill);
+			buf += fill;
+			size -= fill;
+		}
+		tail.assign(capacity - headSize, '\0');
+		tailPos = 0;
+		appendTail(data.data() + headSize, data.size() - headSize);
+		data.resize(headSize);
+		appendTail(buf, size);
+	}
 }
 
-void Case::setProgramArgs(const string &s) {
-	programArgs = s;
+bool OutputBuffer::isTruncated() const {
+	return tail.size() > 0;
 }
 
-string Case::getProgramArgs() {
-	return programArgs;
+bool OutputBuffer::empty() const {
+	return total == 0;
 }
 
-void Case::setVariation(const string &s) {
-	variation = Tools::toLower(Tools::trim(s));
+size_t OutputBuffer::size() const {
+	return data.size() + tail.size();
 }
 
-string Case::getVariation() {
-	return variation;
+// Contiguous output, built only if truncated and changed
+const string &OutputBuffer::view() {
+	if (! isTruncated()) {
+		return data;
+	}
+	if (! joinedValid) {
+		joined.reserve(size() + 5);
+		joined = data;
+		joined += "\n...\n";
+		joined.append(tail, tailPos, string::npos);
+		joined.append(tail, 0, tailPos);
+		joinedValid = true;
+	}
+	return joined;
+}
+
+void OutputBuffer::resize(size_t size) {
+	if (isTruncated()) {
+		data = view();
+		tail.clear();
+		tailPos = 0;
+	}
+	data.resize(size);
+	joinedValid = false;
 }
 
 /**
- * Class TestCase Definitions
- * TestCase represents cases of test
+ * Class LineDiff Definitions
  */
+LineDiff::LineDiff(const string &expectedText, const string &programText) {
+	split(expectedText, expected, expectedHash);
+	split(programText, program, programHash);
+	size_t eFrom = 0, pFrom = 0;
+	size_t eTo = expected.size(), pTo = program.size();
+	while (eFrom < eTo && pFrom < pTo && equal(eFrom, pFrom)) {
+		eFrom++;
+		pFrom++;
+	}
+	while (eFrom < eTo && pFrom < pTo && equal(eTo - 1, pTo - 1)) {
+		eTo--;
+		pTo--;
+	}
+	if (! diff(eFrom, eTo, pFrom, pTo)) { // Too many differences, shows from the first one
+		hunks.clear();
+		hunks.push_back({eFrom, eTo, pFrom, pTo});
+	}
+	if (hunks.size()) {
+		firstProgramLine = hunks[0].programFrom + 1;
+	} else { // Same lines, shows the end
+		firstProgramLine = 0;
+		hunks.push_back({eTo, eTo, pTo, pTo});
+	}
+	addContext();
+}
 
-void TestCase::cutOutputTooLarge(string &output) {
-	if (output.size() > MAXOUTPUT) {
-		outputTooLarge = true;
-		output.erase(0, output.size() - MAXOUTPUT);
+// Lines without their end of line, as Tools::splitLines
+void LineDiff::split(const string &text, vector<string_view> &lines, vector<size_t> &hashes) {
+	hash<string_view> hasher;
+	const char *data = text.data();
+	size_t size = text.size();
+	size_t start = 0;
+	while (start < size) {
+		const char *nl = (const char *) memchr(data + start, '\n', size - start);
+		size_t end = nl ? nl - data : size;
+		size_t len = end - start;
+		if (len > 0 && data[end - 1] == '\r') {
+			len--;
+		}
+		lines.push_back(string_view(data + start, len));
+		hashes.push_back(hasher(lines.back()));
+		start = end + 1;
 	}
 }
 
-void TestCase::readWrite(int fdread, int fdwrite) {
-	const int MAX = 1024* 10 ;
+bool LineDiff::equal(size_t e, size_t p) const {
+	return expectedHash[e] == programHash[p] && expected[e] == program[p];
+}
+
+// Hunks of one line for each edit of the shortest edit script, false if it needs more than MAXDIFFEDITS
+bool LineDiff::diff(size_t eFrom, size_t eTo, size_t pFrom, size_t pTo) {
+	long n = eTo - eFrom, m = pTo - pFrom;
+	long max = min(n + m, (long) MAXDIFFEDITS);
+	long offset = max + 1;
+	vector<long> v(2 * max + 3, 0);
+	vector< vector<long> > trace;
+	long d, found = -1;
+	for (d = 0; d <= max && found < 0; d++) {
+		trace.push_back(v);
+		for (long k = -d; k <= d; k += 2) {
+			long x;
+			if (k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1])) {
+				x = v[offset + k + 1];
+			} else {
+				x = v[offset + k - 1] + 1;
+			}
+			long y = x - k;
+			while (x < n && y < m && equal(eFrom + x, pFrom + y)) {
+				x++;
+				y++;
+			}
+			v[offset + k] = x;
+			if (x >= n && y >= m) {
+				found = d;
+				break;
+			}
+		}
+	}
+	if (found < 0) {
+		return false;
+	}
+	long x = n, y = m;
+	for (d = found; d > 0; d--) {
+		const vector<long> &pv = trace[d];
+		long k = x - y;
+		long pk;
+		if (k == -d || (k != d && pv[offset + k - 1] < pv[offset + k + 1])) {
+			pk = k + 1; // Line added by the program
+		} else {
+			pk = k - 1; // Expected line missing
+		}
+		long px = pv[offset + pk];
+		long py = px - pk;
+		if (pk == k + 1) {
+			hunks.push_back({eFrom + px, eFrom + px, pFrom + py, pFrom + py + 1});
+		} else {
+			hunks.push_back({eFrom + px, eFrom + px + 1, pFrom + py, pFrom + py});
+		}
+		x = px;
+		y = py;
+	}
+	reverse(hunks.begin(), hunks.end());
+	return true;
+}
+
+// Joins the hunks that are near and adds the lines around them
+void LineDiff::addContext() {
+	vector<Hunk> joined;
+	for (const Hunk &hunk : hunks) {
+		if (joined.size() && hunk.expectedFrom <= joined.back().expectedTo + 2 * DIFFCONTEXT
+				&& hunk.programFrom <= joined.back().programTo + 2 * DIFFCONTEXT) {
+			joined.back().expectedTo = hunk.expectedTo;
+			joined.back().programTo = hunk.programTo;
+		} else {
+			joined.push_back(hunk);
+		}
+	}
+	for (Hunk &hunk : joined) {
+		size_t before = min(min(hunk.expectedFrom, hunk.programFrom), (size_t) DIFFCONTEXT);
+		size_t after = min(min(expected.size() - hunk.expectedTo, program.size() - hunk.programTo),
+				(size_t) DIFFCONTEXT);
+		hunk.expectedFrom -= before;
+		hunk.programFrom -= before;
+		hunk.expectedTo += after;
+		hunk.programTo += after;
+	}
+	hunks = joined;
+}
+
+// 0 if the lines are the same
+size_t LineDiff::getFirstProgramLine() const {
+	return firstProgramLine;
+}
+
+// Lines of the hunks that fit in budget and maxLines, "..." marks the lines not shown
+string LineDiff::excerpt(const vector<string_view> &lines, bool isExpected, size_t budget, int maxLines) const {
+	string res;
+	size_t next = 0;
+	int nlines = 0;
+	for (const Hunk &hunk : hunks) {
+		size_t from = isExpected ? hunk.expectedFrom : hunk.programFrom;
+		size_t to = isExpected ? hunk.expectedTo : hunk.programTo;
+		if (from > next) {
+			res += "...\n";
+		}
+		for (size_t i = max(from, next); i < to; i++) {
+			if (res.size() + lines[i].size() >= budget || nlines == maxLines) {
+				if (nlines < maxLines) {
+					res.append(lines[i].substr(0, budget - min(budget, res.size())));
+				}
+				res += "...\n";
+				return res;
+			}
+			nlines++;
+			res.append(lines[i]);
+			res += '\n';
+		}
+		next = max(next, to);
+	}
+	if (next < lines.size()) {
+		res += "...\n";
+	}
+	return res;
+}
+
+string LineDiff::expectedExcerpt(size_t budget, int maxLines) const {
+	return excerpt(expected, true, budget, maxLines);
+}
+
+string LineDiff::programExcerpt(size_t budget, int maxLines) const {
+	return excerpt(program, false, budget, maxLines);
+}
+
+/**
+ * Class Case Definitions
+ * Case represents cases
+ */
+Case::Case() {
+	reset();
+}
+
+void Case::reset() {
+	input = "";
+	output.clear();
+	caseDescription = "";
+	gradeReduction = std::numeric_limits<float>::min();
+	failMessage = "";
+	programToRun = "";
+	programArgs = "";
+	variation = "";
+	expectedExitCode = std::numeric_limits<int>::min();
+	timeout = 0;
+	persistent = false;
+	inputEnd = "";
+	outputEnd = "";
+	limits = CaseLimits();
+	inputFile = "";
+	checker = "";
+}
+
+void Case::addInput(string s) {
+	input += s;
+}
+
+string Case::getInput() {
+	return input;
+}
+
+void Case::addOutput(string o) {
+	output.push_back(o);
+}
+
+const vector< string > & Case::getOutput() {
+	return output;
+}
+
+void Case::setFailMessage(const string &s) {
+	failMessage = s;
+}
+
+string Case::getFailMessage() {
+	return failMessage;
+}
+void Case::setCaseDescription(const string &s) {
+	caseDescription = s;
+}
+
+string Case::getCaseDescription() {
+	return caseDescription;
+}
+void Case::setGradeReduction(float g) {
+	gradeReduction = g;
+}
+
+float Case::getGradeReduction() {
+	return gradeReduction;
+}
+
+void Case::setExpectedExitCode(int e) {
+	expectedExitCode = e;
+}
+
+int Case::getExpectedExitCode() {
+	return expectedExitCode;
+}
+void Case::setProgramToRun(const string &s) {
+	programToRun = s;
+}
+
+string Case::getProgramToRun() {
+	return programToRun;
+}
+
+void Case::setProgramArgs(const string &s) {
+	programArgs = s;
+}
+
+string Case::getProgramArgs() {
+	return programArgs;
+}
+
+void Case::setTimeout(double t) {
+	timeout = t;
+}
+
+double Case::getTimeout() {
+	return timeout;
+}
+
+void Case::setPersistent(const string &inputEnd, const string &outputEnd) {
+	persistent = true;
+	this->inputEnd = inputEnd;
+	this->outputEnd = outputEnd;
+}
+
+bool Case::isPersistent() {
+	return persistent;
+}
+
+string Case::getInputEnd() {
+	return inputEnd;
+}
+
+string Case::getOutputEnd() {
+	return outputEnd;
+}
+
+CaseLimits &Case::getLimits() {
+	return limits;
+}
+
+void Case::setInputFile(const string &inputFile) {
+	this->inputFile = inputFile;
+}
+
+string Case::getInputFile() {
+	return inputFile;
+}
+
+void Case::setChecker(const string &s) {
+	checker = s;
+}
+
+string Case::getChecker() {
+	return checker;
+}
+
+void Case::setVariation(const string &s) {
+	variation = Tools::toLower(Tools::trim(s));
+}
+
+string Case::getVariation() {
+	return variation;
+}
+
+/**
+ * Class Cgroup Definitions
+ */
+
+// The base cgroup must be writable and have no processes, usually delegated by systemd
+void Cgroup::setup(const string &base, rlim_t memory, rlim_t processes, double cpus) {
+	Cgroup::base = base;
+	Cgroup::defaultMemory = memory;
+	Cgroup::defaultProcesses = processes;
+	Cgroup::cpus = cpus;
+	if (base.size()) { // Controllers for the leaves, one by one, some may be missing
+		writeFile(base + "/cgroup.subtree_control", "+memory");
+		writeFile(base + "/cgroup.subtree_control", "+cpu");
+		writeFile(base + "/cgroup.subtree_control", "+pids");
+	}
+}
+
+bool Cgroup::isEnabled() {
+	return base.size() > 0;
+}
+
+Cgroup::Cgroup() {
+	procsFd = -1;
+	memoryLimit = 0;
+}
+
+Cgroup::~Cgroup() {
+	destroy();
+}
+
+bool Cgroup::writeFile(const string &fname, const string &value) {
+	int fd = open(fname.c_str(), O_WRONLY | O_CLOEXEC);
+	if (fd < 0) {
+		return false;
+	}
+	bool ok = write(fd, value.c_str(), value.size()) == (ssize_t) value.size();
+	close(fd);
+	return ok;
+}
+
+// Limits not supported by the kernel or not delegated are ignored
+bool Cgroup::create(const CaseLimits &limits) {
+	destroy();
+	string leaf = base + "/vpl_" + to_string(getpid()) + "_" + to_string(nextId++);
+	if (mkdir(leaf.c_str(), 0755) != 0) {
+		return false;
+	}
+	path = leaf;
+	procsFd = open((path + "/cgroup.procs").c_str(), O_WRONLY | O_CLOEXEC);
+	if (procsFd < 0) {
+		destroy();
+		return false;
+	}
+	memoryLimit = limits.memory ? limits.memory : defaultMemory;
+	if (memoryLimit) {
+		writeFile(path + "/memory.max", to_string(memoryLimit));
+		writeFile(path + "/memory.swap.max", "0");
+	}
+	rlim_t processes = limits.processes ? limits.processes : defaultProcesses;
+	if (processes) {
+		writeFile(path + "/pids.max", to_string(processes));
+	}
+	if (cpus > 0) {
+		const long period = 100000;
+		writeFile(path + "/cpu.max", to_string((long) (cpus * period)) + " " + to_string(period));
+	}
+	return true;
+}
+
+int Cgroup::getProcsFd() {
+	return procsFd;
+}
+
+rlim_t Cgroup::getMemoryLimit() {
+	return memoryLimit;
+}
+
+// Sets the CPU time and the memory peak of all the processes that run in the cgroup
+bool Cgroup::readUsage(struct rusage &usage) {
+	if (path.size() == 0) {
+		return false;
+	}
+	vector<string> lines = Tools::splitLines(Tools::readFile(path + "/cpu.stat"));
+	bool read = false;
+	for (size_t i = 0; i < lines.size(); i++) {
+		unsigned long long usec;
+		if (sscanf(lines[i].c_str(), "user_usec %llu", &usec) == 1) {
+			usage.ru_utime.tv_sec = usec / 1000000;
+			usage.ru_utime.tv_usec = usec % 1000000;
+			read = true;
+		} else if (sscanf(lines[i].c_str(), "system_usec %llu", &usec) == 1) {
+			usage.ru_stime.tv_sec = usec / 1000000;
+			usage.ru_stime.tv_usec = usec % 1000000;
+			read = true;
+		}
+	}
+	long long peak;
+	if (sscanf(Tools::readFile(path + "/memory.peak").c_str(), "%lld", &peak) == 1) {
+		usage.ru_maxrss = peak / 1024;
+		read = true;
+	}
+	return read;
+}
+
+bool Cgroup::isOOMKilled() {
+	if (path.size() == 0) {
+		return false;
+	}
+	vector<string> lines = Tools::splitLines(Tools::readFile(path + "/memory.events"));
+	for (size_t i = 0; i < lines.size(); i++) {
+		unsigned long count;
+		if (sscanf(lines[i].c_str(), "oom_kill %lu", &count) == 1) {
+			return count > 0;
+		}
+	}
+	return false;
+}
+
+// Kills the processes left in the cgroup and removes it
+void Cgroup::destroy() {
+	if (procsFd >= 0) {
+		close(procsFd);
+		procsFd = -1;
+	}
+	if (path.size() == 0) {
+		return;
+	}
+	writeFile(path + "/cgroup.kill", "1");
+	// The cgroup can be removed when its killed processes are gone
+	for (int i = 0; i < 100 && rmdir(path.c_str()) != 0 && errno == EBUSY; i++) {
+		usleep(1000);
+	}
+	path = "";
+}
+
+/**
+ * Class ProcessLauncher Definitions
+ */
+
+ProcessLauncher::ProcessLauncher(const char *command, const char **argv, const char **envv,
+		int fdin, int fdout, const CaseLimits &limits) :limits(limits) {
+	cgroupFd = -1;
+	userTasks = 0;
+	this->command = command;
+	this->argv = argv;
+	this->envv = envv;
+	this->fdin = fdin;
+	this->fdout = fdout;
+	extraFds = NULL;
+	nextraFds = 0;
+	execError = 0;
+}
+
+// Runs in the memory of the evaluator: only async-signal-safe calls
+int ProcessLauncher::child(void *arg) {
+	ProcessLauncher *launcher = (ProcessLauncher *) arg;
+	// The signal handlers of the evaluator must not run here
+	struct sigaction action;
+	memset(&action, 0, sizeof(action));
+	action.sa_handler = SIG_DFL;
+	for (int i = 1; i < NSIG; i++) {
+		sigaction(i, &action, NULL);
+	}
+	sigprocmask(SIG_SETMASK, &launcher->parentMask, NULL);
+	dup2(launcher->fdin, STDIN_FILENO);
+	dup2(launcher->fdout, STDOUT_FILENO);
+	dup2(launcher->fdout, STDERR_FILENO);
+	if (launcher->nextraFds) { // Moved out of the way first, they may be 3, 4...
+		int *moved = (int *) alloca(launcher->nextraFds * sizeof(int));
+		for (int i = 0; i < launcher->nextraFds; i++) {
+			moved[i] = fcntl(launcher->extraFds[i], F_DUPFD_CLOEXEC, 3 + launcher->nextraFds);
+		}
+		for (int i = 0; i < launcher->nextraFds; i++) {
+			dup2(moved[i], 3 + i);
+		}
+	}
+	setpgid(0, 0);
+	// Outside the cgroup the rlimits still apply
+	bool inCgroup = launcher->cgroupFd >= 0 && write(launcher->cgroupFd, "0", 1) == 1;
+	// Crashing programs must not spend time dumping core
+	setLimit(RLIMIT_CORE, 0, 0);
+	const CaseLimits &limits = launcher->limits;
+	if (limits.memory) {
+		setLimit(RLIMIT_AS, limits.memory, limits.memory);
+	}
+	if (limits.cputime) { // SIGXCPU at the soft limit, SIGKILL one second later
+		setLimit(RLIMIT_CPU, limits.cputime, limits.cputime + 1);
+	}
+	if (limits.filesize) {
+		setLimit(RLIMIT_FSIZE, limits.filesize, limits.filesize);
+	}
+	// pids.max of the cgroup counts only the processes of the case. RLIMIT_NPROC counts
+	// all those of the user: the evaluator, its threads and the programs of other cases
+	if (limits.processes && ! inCgroup) {
+		rlim_t processes = launcher->userTasks + limits.processes;
+		setLimit(RLIMIT_NPROC, processes, processes);
+	}
+	execve(launcher->command, (char * const *) launcher->argv, (char * const *) launcher->envv);
+	launcher->execError = errno;
+	_exit(127);
+}
+
+void ProcessLauncher::setCgroup(int cgroupFd) {
+	this->cgroupFd = cgroupFd;
+}
+
+void ProcessLauncher::setExtraFds(const int *fds, int n) {
+	extraFds = fds;
+	nextraFds = n;
+}
+
+// Only lowers the limits, the jail may have set stricter ones
+void ProcessLauncher::setLimit(int resource, rlim_t soft, rlim_t hard) {
+	struct rlimit limit;
+	if (getrlimit(resource, &limit) == 0) {
+		limit.rlim_cur = min(limit.rlim_cur, soft);
+		limit.rlim_max = min(limit.rlim_max, hard);
+		limit.rlim_cur = min(limit.rlim_cur, limit.rlim_max);
+		setrlimit(resource, &limit);
+	}
+}
+
+// Returns -1 if the program can not be started, see getExecError()
+pid_t ProcessLauncher::launch() {
+	alignas(16) char stack[STACKSIZE];
+	sigset_t all;
+	sigfillset(&all);
+	if (limits.processes) {
+		userTasks = Tools::userTasks();
+	}
+	// Blocked until the child resets the handlers
+	pthread_sigmask(SIG_SETMASK, &all, &parentMask);
+	// Returns after the child calls execve or ends
+	pid_t pid = clone(child, stack + STACKSIZE, CLONE_VM | CLONE_VFORK | SIGCHLD, this);
+	int cloneErrno = errno;
+	pthread_sigmask(SIG_SETMASK, &parentMask, NULL);
+	if (pid > 0 && execError) {
+		waitpid(pid, NULL, 0);
+		return -1;
+	}
+	errno = cloneErrno;
+	return pid;
+}
+
+int ProcessLauncher::getExecError() {
+	return execError;
+}
+
+/**
+ * Class PersistentProcess Definitions
+ */
+
+PersistentProcess::PersistentProcess() {
+	pid = -1;
+	fdwrite = -1;
+	fdread = -1;
+	pidfd = -1;
+}
+
+PersistentProcess::~PersistentProcess() {
+	stop();
+}
+
+bool PersistentProcess::isRunning(const string &key) {
+	return pid > 0 && this->key == key;
+}
+
+void PersistentProcess::start(const string &key, pid_t pid, int fdwrite, int fdread) {
+	this->key = key;
+	this->pid = pid;
+	this->fdwrite = fdwrite;
+	this->fdread = fdread;
+	pidfd = Tools::pidfdOpen(pid);
+}
+
+// Closes the pipes of a program already ended and waited
+void PersistentProcess::release() {
+	if (fdwrite >= 0) {
+		close(fdwrite);
+	}
+	if (fdread >= 0) {
+		close(fdread);
+	}
+	if (pidfd >= 0) {
+		close(pidfd);
+	}
+	pid = -1;
+	fdwrite = -1;
+	fdread = -1;
+	pidfd = -1;
+}
+
+// Returns the number of processes left by the program
+int PersistentProcess::stop() {
+	int strays = 0;
+	if (pid > 0) {
+		struct rusage usage;
+		bool reaped;
+		strays = Tools::endProcessGroup(pid, usage, reaped);
+	}
+	release();
+	cgroup.destroy();
+	return strays;
+}
+
+/**
+ * Class TestCase Definitions
+ * TestCase represents cases of test
+ */
+
+// Waits up to waitms for program output, room to write its input or its end (pidfd).
+// Closed descriptors are set to -1. Persistent programs keep their input open.
+void TestCase::readWrite(int &fdread, int &fdwrite, int pidfd, int waitms, bool closeInput) {
+	const int MAX = 1024 * 64;
 	// Buffer size to read
+	const int MAXREADS = 16;
+	// Reads per call, then gives its turn to the writer
 	const int POLLREAD = POLLIN | POLLPRI;
+	const int POLLCLOSED = POLLHUP | POLLERR;
 	// Poll to read from program
-	struct pollfd devices[2];
+	struct pollfd devices[3];
 	devices[0].fd = fdread;
-	devices[1].fd = fdwrite;
-	char buf[MAX];
+	size_t pending = programInput.size() - programInputSent;
+	devices[1].fd = pending > 0 ? fdwrite : -1;
+	devices[2].fd = pidfd;
 	devices[0].events = POLLREAD;
 	devices[1].events = POLLOUT;
-	int res = poll(devices, programInput.size()>0?2:1, 0);
+	devices[2].events = POLLIN;
+	int res = poll(devices, 3, waitms);
 	if (res == -1) // Error
 		return;
 	if (res == 0) // Nothing to do
 		return;
-	if (devices[0].revents & POLLREAD) { // Read program output
-		int readed = read(fdread, buf, MAX);
-		if (readed > 0) {
-			sizeReaded += readed;
-			if (programInput.size() > 1) {
-				programOutputBefore += string(buf, readed);
-				cutOutputTooLarge(programOutputBefore);
-			} else {
-				programOutputAfter += string(buf, readed);
-				cutOutputTooLarge(programOutputAfter);
+	if (devices[0].revents & (POLLREAD | POLLCLOSED)) { // Read program output
+		char buf[MAX];
+		for (int i = 0; i < MAXREADS; i++) {
+			int readed = read(fdread, buf, MAX);
+			if (readed > 0) {
+				sizeReaded += readed;
+				OutputBuffer &store = pending > 1 ? programOutputBefore : programOutputAfter;
+				store.append(buf, readed);
+				if (store.isTruncated()) {
+					outputTooLarge = true;
+				}
+				if (pending > 1) { // Matched with the output after it, not alone
+					streamCheckers.clear();
+				} else if (streamCheckers.size()) {
+					for (size_t c = 0; c < streamCheckers.size(); ) {
+						if (streamCheckers[c]->add(buf, readed)) {
+							c++;
+						} else {
+							streamCheckers.erase(streamCheckers.begin() + c);
+						}
+					}
+					outputMismatch = streamCheckers.empty();
+				}
+				if (readed == MAX) {
+					continue;
+				}
+			} else if (readed == 0) { // End of output
+				close(fdread);
+				fdread = -1;
 			}
+			break;
 		}
 	}
-	if (programInput.size() > 0 && devices[1].revents & POLLOUT) { // Write to program
-		int written = write(fdwrite, programInput.c_str(), Tools::nextLine(
-				programInput));
-		if (written > 0) {
-			programInput.erase(0, written);
+	if (devices[1].revents & (POLLOUT | POLLCLOSED)) { // Write to program
+		// Fills the pipe, the program reads while the evaluator waits
+		while (programInputSent < programInput.size()) {
+			size_t size = lineInput ? Tools::nextLine(programInput, programInputSent)
+					: programInput.size() - programInputSent;
+			ssize_t written = write(fdwrite, programInput.data() + programInputSent, size);
+			if (written > 0) {
+				programInputSent += written;
+				if (lineInput || (size_t) written < size) {
+					break; // Line paced or pipe full
+				}
+			} else {
+				if (written == -1 && errno != EAGAIN && errno != EINTR) {
+					programInputSent = programInput.size(); // The program does not read its input
+					closeInput = true;
+				}
+				break;
+			}
 		}
-		if(programInput.size()==0){
+		if(programInputSent == programInput.size() && closeInput){
 			close(fdwrite);
+			fdwrite = -1;
 		}
 	}
 }
@@ -1930,6 +3983,18 @@ void TestCase::setEnvironment(const char **environment) {
 	envv = environment;
 }
 
+void TestCase::setLineInput(bool lineInput) {
+	TestCase::lineInput = lineInput;
+}
+
+void TestCase::setFileCapture(bool fileCapture) {
+	TestCase::fileCapture = fileCapture;
+}
+
+void TestCase::setEarlyStop(bool earlyStop) {
+	TestCase::earlyStop = earlyStop;
+}
+
 void TestCase::setDefaultCommand() {
 	command = "./vpl_test";
 	argv = new const char*[2];
@@ -1942,6 +4007,7 @@ TestCase::TestCase(const TestCase &o) {
 	correctOutput=o.correctOutput;
 	correctExitCode = o.correctExitCode;
 	outputTooLarge=o.outputTooLarge;
+	outputMismatch=o.outputMismatch;
 	programTimeout=o.programTimeout;
 	executionError=o.executionError;
 	strcpy(executionErrorReason,o.executionErrorReason);
@@ -1951,6 +4017,18 @@ TestCase::TestCase(const TestCase &o) {
 	gradeReduction=o.gradeReduction;
 	expectedExitCode = o.expectedExitCode;
 	exitCode = o.exitCode;
+	timeout = o.timeout;
+	duration = o.duration;
+	checkDuration = o.checkDuration;
+	persistent = o.persistent;
+	inputEnd = o.inputEnd;
+	outputEnd = o.outputEnd;
+	usage = o.usage;
+	usageAvailable = o.usageAvailable;
+	inputFile = o.inputFile;
+	limits = o.limits;
+	limitReason = o.limitReason;
+	strays = o.strays;
 	failMessage=o.failMessage;
 	programToRun=o.programToRun;
 	programArgs=o.programArgs;
@@ -1958,6 +4036,7 @@ TestCase::TestCase(const TestCase &o) {
 	programOutputBefore=o.programOutputBefore;
 	programOutputAfter=o.programOutputAfter;
 	programInput=o.programInput;
+	programInputSent=o.programInputSent;
 	for(size_t i = 0; i < o.output.size(); i++){
 		output.push_back(o.output[i]->clone());
 	}
@@ -1969,6 +4048,7 @@ TestCase& TestCase::operator=(const TestCase &o) {
 	correctOutput=o.correctOutput;
 	correctExitCode = o.correctExitCode;
 	outputTooLarge=o.outputTooLarge;
+	outputMismatch=o.outputMismatch;
 	programTimeout=o.programTimeout;
 	executionError=o.executionError;
 	strcpy(executionErrorReason,o.executionErrorReason);
@@ -1981,10 +4061,23 @@ TestCase& TestCase::operator=(const TestCase &o) {
 	programArgs=o.programArgs;
 	expectedExitCode = o.expectedExitCode;
 	exitCode = o.exitCode;
+	timeout = o.timeout;
+	duration = o.duration;
+	checkDuration = o.checkDuration;
+	persistent = o.persistent;
+	inputEnd = o.inputEnd;
+	outputEnd = o.outputEnd;
+	usage = o.usage;
+	usageAvailable = o.usageAvailable;
+	inputFile = o.inputFile;
+	limits = o.limits;
+	limitReason = o.limitReason;
+	strays = o.strays;
 	gradeReductionApplied=o.gradeReductionApplied;
 	programOutputBefore=o.programOutputBefore;
 	programOutputAfter=o.programOutputAfter;
 	programInput=o.programInput;
+	programInputSent=o.programInputSent;
 	for(size_t i=0; i<output.size(); i++)
 		delete output[i];
 	output.clear();
@@ -2001,7 +4094,8 @@ TestCase::~TestCase() {
 
 TestCase::TestCase(int id, const string &input, const vector<string> &output,
 		const string &caseDescription, const float gradeReduction,
-		string failMessage, string programToRun, string programArgs, int expectedExitCode) {
+		string failMessage, string programToRun, string programArgs, int expectedExitCode,
+		double timeout) {
 	this->id = id;
 	this->input = input;
 	for(size_t i = 0; i < output.size(); i++){
@@ -2013,8 +4107,17 @@ TestCase::TestCase(int id, const string &input, const vector<string> &output,
 	this->programToRun = programToRun;
 	this->programArgs = programArgs;
 	this->failMessage = failMessage;
+	this->timeout = timeout;
+	duration = 0;
+	checkDuration = 0;
+	persistent = false;
+	memset(&usage, 0, sizeof(usage));
+	usageAvailable = false;
+	strays = 0;
+	programInputSent = 0;
 	exitCode = std::numeric_limits<int>::min();
 	outputTooLarge = false;
+	outputMismatch = false;
 	programTimeout = false;
 	executionError = false;
 	correctOutput = false;
@@ -2041,6 +4144,71 @@ float TestCase::getGradeReduction() {
 	return gradeReduction;
 }
 
+double TestCase::getTimeout() {
+	return timeout;
+}
+
+double TestCase::getDuration() {
+	return duration;
+}
+
+double TestCase::getCheckDuration() {
+	return checkDuration;
+}
+
+bool TestCase::isTimeout() {
+	return programTimeout;
+}
+
+bool TestCase::isUsageAvailable() {
+	return usageAvailable;
+}
+
+const struct rusage &TestCase::getUsage() {
+	return usage;
+}
+
+int TestCase::getExitCode() {
+	return exitCode;
+}
+
+int TestCase::getStrays() {
+	return strays;
+}
+
+// The exit code can not be tested if the program runs more cases,
+// and an input file can not be its standard input
+void TestCase::setPersistent(const string &inputEnd, const string &outputEnd) {
+	persistent = ! isExitCodeTested() && inputFile.size() == 0;
+	this->inputEnd = inputEnd;
+	this->outputEnd = outputEnd;
+}
+
+void TestCase::setLimits(const CaseLimits &limits) {
+	this->limits = limits;
+}
+
+void TestCase::setInputFile(const string &inputFile) {
+	this->inputFile = inputFile;
+}
+
+// The outputs are checked by the checker, each one with an expected output
+void TestCase::setChecker(const string &checker, const vector<string> &expected) {
+	for (size_t i = 0; i < output.size(); i++)
+		delete output[i];
+	output.clear();
+	for (size_t i = 0; i < expected.size(); i++)
+		output.push_back(new CheckerOutput(checker, expected[i], input, inputFile));
+	if (expected.size() == 0)
+		output.push_back(new CheckerOutput(checker, "", input, inputFile));
+}
+
+bool TestCase::sharesProcessWith(const TestCase &o) {
+	return persistent && o.persistent && programToRun == o.programToRun
+			&& programArgs == o.programArgs && inputEnd == o.inputEnd
+			&& outputEnd == o.outputEnd && limits == o.limits;
+}
+
 void TestCase::setGradeReductionApplied(float r) {
 	gradeReductionApplied=r;
 }
@@ -2069,6 +4237,35 @@ string TestCase::getCommentTitle(bool withGradeReduction=false) {
 	return ret;
 }
 
+// Name, size and first lines of the input file
+string TestCase::getInputFileSummary() {
+	const int HEADSIZE = 512;
+	const int HEADLINES = 10;
+	char buf[HEADSIZE + 250];
+	struct stat info;
+	if (stat(inputFile.c_str(), &info) != 0) {
+		return "";
+	}
+	sprintf(buf, (L->langEvaluate(56)).c_str(), inputFile.c_str(), (long long) info.st_size);
+	string ret = buf;
+	FILE *f = fopen(inputFile.c_str(), "r");
+	if (f != NULL) {
+		size_t size = fread(buf, 1, HEADSIZE, f);
+		fclose(f);
+		string head(buf, size);
+		size_t end = 0;
+		for (int line = 0; line < HEADLINES && end < head.size(); line++) {
+			end += Tools::nextLine(head, end);
+		}
+		if ((long long) end < (long long) info.st_size) {
+			head.resize(end);
+			head += "...\n";
+		}
+		ret += Tools::caseFormat(head);
+	}
+	return ret;
+}
+
 string TestCase::getComment() {
 	if (isCorrectResult()) {
 		return "";
@@ -2081,6 +4278,9 @@ string TestCase::getComment() {
 	if (programTimeout) {
 		ret += (L->langEvaluate(12)).c_str();
 	}
+	if (outputMismatch) {
+		ret += (L->langEvaluate(57)).c_str();
+	}
 	if (outputTooLarge) {
 		sprintf(buf, (L->langEvaluate(13)).c_str(), sizeReaded / 1024);
 		ret += buf;
@@ -2088,6 +4288,9 @@ string TestCase::getComment() {
 	if (executionError) {
 		ret += executionErrorReason + string("\n");
 	}
+	if (limitReason.size()) {
+		ret += limitReason;
+	}
 	if (isExitCodeTested() && ! correctExitCode) {
 		char buf[250];
 		sprintf(buf, (L->langEvaluate(14)).c_str(), expectedExitCode, exitCode);
@@ -2097,17 +4300,56 @@ string TestCase::getComment() {
 		if (failMessage.size()) {
 			ret += failMessage + "\n";
 		} else {
+			string programOutput = programOutputBefore.view() + programOutputAfter.view();
+			string expected = output.size() > 0 ? output[0]->studentOutputExpected() : "";
+			bool small = programOutput.size() <= COMMENTSECTIONSIZE && expected.size() <= COMMENTSECTIONSIZE;
 			ret += (L->langEvaluate(15)).c_str();
+			for (size_t i = 0; i < output.size(); i++) {
+				string message = output[i]->getMessage();
+				if (message.size()) {
+					ret += Tools::caseFormat(message);
+					break;
+				}
+			}
+			unique_ptr<LineDiff> diff;
+			// Only the lines around the first differences of large exact text outputs
+			if (! small && ! programTimeout && output.size() > 0
+					&& dynamic_cast<ExactTextOutput*>(output[0]) != NULL) {
+				diff.reset(new LineDiff(expected, programOutput));
+				if (diff->getFirstProgramLine() > 0) {
+					sprintf(buf, (L->langEvaluate(58)).c_str(), (unsigned long) diff->getFirstProgramLine());
+					ret += buf;
+				}
+			}
 			ret += (L->langEvaluate(16)).c_str();
-			ret += Tools::caseFormat(input);
+			ret += inputFile.size() ? getInputFileSummary()
+					: Tools::caseFormat(Tools::headLines(input, COMMENTSECTIONSIZE));
 			ret += (L->langEvaluate(17)).c_str();
-			ret += Tools::caseFormat(programOutputBefore + programOutputAfter);
+			if (diff) {
+				ret += Tools::caseFormat(programOutput.size() <= COMMENTSECTIONSIZE ? programOutput
+						: diff->programExcerpt(COMMENTSECTIONSIZE, COMMENTSECTIONLINES));
+			} else {
+				ret += Tools::caseFormat(Tools::headLines(programOutput, COMMENTSECTIONSIZE));
+			}
 			if(output.size()>0){
 				ret += (L->langEvaluate(18)).c_str()+output[0]->type()+")\n";
-				ret += Tools::caseFormat(output[0]->studentOutputExpected());
+				if (diff) {
+					ret += Tools::caseFormat(expected.size() <= COMMENTSECTIONSIZE ? expected
+							: diff->expectedExcerpt(COMMENTSECTIONSIZE, COMMENTSECTIONLINES));
+				} else {
+					ret += Tools::caseFormat(Tools::headLines(expected, COMMENTSECTIONSIZE));
+				}
 			}
 		}
 	}
+	if (usageAvailable) {
+		char buf[250];
+		sprintf(buf, (L->langEvaluate(48)).c_str(), duration,
+				Tools::seconds(usage.ru_utime), Tools::seconds(usage.ru_stime),
+				usage.ru_maxrss, usage.ru_minflt + usage.ru_majflt, usage.ru_majflt,
+				usage.ru_nvcsw + usage.ru_nivcsw, usage.ru_nivcsw);
+		ret += buf;
+	}
 	return ret;
 }
 
@@ -2147,122 +4389,703 @@ void TestCase::splitArgs(string programArgs) {
 	argv[nargs] = NULL;
 }
 
-void TestCase::runTest(time_t timeout) {// Timeout in seconds
-	time_t start = time(NULL);
-	int pp1[2]; // Send data
-	int pp2[2]; // Receive data
-	if (pipe(pp1) == -1 || pipe(pp2) == -1) {
+// Starts the program of the case with its input and output piped
+// The output goes to fdoutput if set, else to a pipe read by the evaluator
+bool TestCase::startProgram(pid_t &pid, int &fdwrite, int &fdread, Cgroup &cgroup, int fdoutput) {
+	int pp1[2]; // Send data
+	int pp2[2]; // Receive data
+	if ( programToRun > "" && programToRun.size() < 512) {
+		command = programToRun.c_str();
+	}
+	if ( ! Tools::existFile(command) ){
+		executionError = true;
+		sprintf(executionErrorReason, (L->langEvaluate(20)).c_str(), command);
+		return false;
+	}
+	if (inputFile.size()) { // The file is the standard input of the program, not copied
+		pp1[0] = open(inputFile.c_str(), O_RDONLY | O_CLOEXEC);
+		pp1[1] = -1;
+		if (pp1[0] == -1) {
+			executionError = true;
+			snprintf(executionErrorReason, sizeof(executionErrorReason),
+					(L->langEvaluate(55)).c_str(), inputFile.c_str(), strerror(errno));
+			return false;
+		}
+	// Close-on-exec: programs of other cases running concurrently must not inherit these pipes
+	} else if (pipe2(pp1, O_CLOEXEC) == -1) {
+		executionError = true;
+		sprintf(executionErrorReason, (L->langEvaluate(19)).c_str(),
+				strerror(errno));
+		return false;
+	}
+	if (fdoutput >= 0) {
+		pp2[0] = -1;
+		pp2[1] = fdoutput;
+	} else if (pipe2(pp2, O_CLOEXEC) == -1) {
+		close(pp1[0]);
+		if (pp1[1] >= 0) {
+			close(pp1[1]);
+		}
+		executionError = true;
+		sprintf(executionErrorReason, (L->langEvaluate(19)).c_str(),
+				strerror(errno));
+		return false;
+	}
+	if ( programArgs.size() > 0) {
+		splitArgs(programArgs);
+	}
+	// A captured output stops growing just past the size kept, SIGXFSZ tells it is too large
+	CaseLimits programLimits = limits;
+	if (fdoutput >= 0 && output.size() > 0 && ! limits.filesize) {
+		programLimits.filesize = (limits.output ? limits.output : MAXOUTPUT) + 1;
+	}
+	ProcessLauncher launcher(command, argv, envv, pp1[0], pp2[1], programLimits);
+	if (Cgroup::isEnabled() && cgroup.create(limits)) {
+		launcher.setCgroup(cgroup.getProcsFd());
+	}
+	if ((pid = launcher.launch()) == -1) {
+		executionError = true;
+		if (launcher.getExecError()) {
+			snprintf(executionErrorReason, sizeof(executionErrorReason), "%s (%s)",
+					(L->langEvaluate(21)).c_str(), strerror(launcher.getExecError()));
+		} else {
+			sprintf(executionErrorReason, (L->langEvaluate(22)).c_str(),
+					strerror(errno));
+		}
+		close(pp1[0]);
+		if (pp1[1] >= 0) {
+			close(pp1[1]);
+		}
+		if (fdoutput < 0) {
+			close(pp2[0]);
+			close(pp2[1]);
+		}
+		return false;
+	}
+	close(pp1[0]);
+	if (fdoutput < 0) {
+		close(pp2[1]);
+	}
+	fdwrite = pp1[1];
+	fdread = pp2[0];
+	if (fdwrite >= 0) {
+		Tools::fdblock(fdwrite, false);
+	}
+	if (fdread >= 0) {
+		Tools::fdblock(fdread, false);
+	}
+	return true;
+}
+
+// Where the program writes its output instead of a pipe, -1 if a pipe
+int TestCase::openOutput() {
+	if (output.size() == 0 && isExitCodeTested()) { // Only the exit code is tested
+		return open("/dev/null", O_WRONLY | O_CLOEXEC);
+	}
+	// Writes to files are limited by maxfilesize=, those to pipes are not
+	if (fileCapture && ! limits.filesize) {
+		return Tools::memfdCreate("vpl_output");
+	}
+	return -1;
+}
+
+// Keeps the output written to the file, only its beginning and end if too large
+void TestCase::loadOutput(int fdoutput) {
+	struct stat info;
+	if (fstat(fdoutput, &info) != 0 || ! S_ISREG(info.st_mode) || info.st_size == 0) {
+		return;
+	}
+	sizeReaded = (int) min((off_t) INT_MAX, info.st_size);
+	void *data = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fdoutput, 0);
+	if (data == MAP_FAILED) {
+		return;
+	}
+	// Only the pages kept are read
+	programOutputAfter.append((const char *) data, info.st_size);
+	munmap(data, info.st_size);
+	if (programOutputAfter.isTruncated()) {
+		outputTooLarge = true;
+	}
+}
+
+// Usage of the program and its descendants, and memory limit exceeded
+void TestCase::setCgroupUsage(Cgroup &cgroup) {
+	if (cgroup.readUsage(usage)) {
+		usageAvailable = true;
+	}
+	if (cgroup.isOOMKilled()) {
+		char buf[250];
+		sprintf(buf, (L->langEvaluate(53)).c_str(), (unsigned long) cgroup.getMemoryLimit() / 1024);
+		limitReason = buf;
+	}
+}
+
+// Signs of a program out of memory: its peak near the limit or a failed allocation reported
+bool TestCase::isMemoryExhausted() {
+	if (usageAvailable && (rlim_t) usage.ru_maxrss * 1024 >= limits.memory / 10 * 9) {
+		return true;
+	}
+	static const char *messages[] = {"Cannot allocate memory", "cannot allocate", "bad_alloc",
+			"out of memory", "MemoryError", "OutOfMemoryError"};
+	const string &text = programOutputAfter.view();
+	for (size_t i = 0; i < sizeof(messages) / sizeof(messages[0]); i++) {
+		if (text.find(messages[i]) != string::npos) {
+			return true;
+		}
+	}
+	return false;
+}
+
+// Finds the limit exceeded by the program, the memory limit only by its signs
+void TestCase::setLimitReason(int status) {
+	if (limitReason.size()) { // Killed by the out of memory killer
+		return;
+	}
+	char buf[250];
+	int signal = WIFSIGNALED(status) ? WTERMSIG(status) : 0;
+	double cputime = Tools::seconds(usage.ru_utime) + Tools::seconds(usage.ru_stime);
+	if (limits.cputime && (signal == SIGXCPU || (signal == SIGKILL && cputime >= limits.cputime))) {
+		sprintf(buf, (L->langEvaluate(49)).c_str(), (unsigned long) limits.cputime);
+	} else if (limits.filesize && signal == SIGXFSZ) {
+		sprintf(buf, (L->langEvaluate(50)).c_str(), (unsigned long) limits.filesize / 1024);
+	} else if (limits.memory && (signal == SIGSEGV || signal == SIGABRT || signal == SIGKILL
+			|| (WIFEXITED(status) && WEXITSTATUS(status) != 0 && ! isExitCodeTested()))
+			&& isMemoryExhausted()) {
+		sprintf(buf, (L->langEvaluate(51)).c_str(), (unsigned long) limits.memory / 1024);
+	} else {
+		return;
+	}
+	limitReason = buf;
+}
+
+// Sets the result from the status returned by waitpid
+void TestCase::setProgramEnd(int status) {
+	if (WIFSIGNALED(status)) {
+		int signal = WTERMSIG(status);
 		executionError = true;
-		sprintf(executionErrorReason, (L->langEvaluate(19)).c_str(),
-				strerror(errno));
-		return;
-	}
-	if ( programToRun > "" && programToRun.size() < 512) {
-		command = programToRun.c_str();
+		sprintf(executionErrorReason,
+				(L->langEvaluate(23)).c_str(), strsignal(
+						signal), signal);
 	}
-	if ( ! Tools::existFile(command) ){
+	if (WIFEXITED(status)) {
+		exitCode = WEXITSTATUS(status);
+	} else if (! WIFSIGNALED(status)) {
 		executionError = true;
-		sprintf(executionErrorReason, (L->langEvaluate(20)).c_str(), command);
-		return;
+		strcpy(executionErrorReason,
+				(L->langEvaluate(24)).c_str());
 	}
+}
+
+void TestCase::runTest(double timeout) {// Timeout in seconds
+	double start = Timer::now();
 	pid_t pid;
-	if ( programArgs.size() > 0) {
-		splitArgs(programArgs);
-	}
-	if ((pid = fork()) == 0) {
-		// Execute
-		close(pp1[1]);
-		dup2(pp1[0], STDIN_FILENO);
-		close(pp2[0]);
-		dup2(pp2[1], STDOUT_FILENO);
-		dup2(STDOUT_FILENO, STDERR_FILENO);
-		setpgrp();
-		execve(command, (char * const *) argv, (char * const *) envv);
-		perror((L->langEvaluate(21)).c_str());
-		abort(); //end of child
-	}
-	if (pid == -1) {
-		executionError = true;
-		sprintf(executionErrorReason, (L->langEvaluate(22)).c_str(),
-				strerror(errno));
+	int fdwrite, fdread;
+	Cgroup cgroup;
+	int fdoutput = openOutput();
+	if (! startProgram(pid, fdwrite, fdread, cgroup, fdoutput)) {
+		if (fdoutput >= 0) {
+			close(fdoutput);
+		}
 		return;
 	}
-	close(pp1[0]);
-	close(pp2[1]);
-	int fdwrite = pp1[1];
-	int fdread = pp2[0];
-	Tools::fdblock(fdwrite, false);
-	Tools::fdblock(fdread, false);
-	programInput = input;
+	programInput = inputFile.size() ? "" : input;
+	programInputSent = 0;
+	// Only if no output can match the case fails without waiting for the end
+	streamCheckers.clear();
+	if (earlyStop && fdread >= 0 && ! isExitCodeTested()) {
+		for (size_t i = 0; i < output.size(); i++) {
+			OutputStreamChecker *checker = output[i]->streamChecker();
+			if (checker == NULL) {
+				streamCheckers.clear();
+				break;
+			}
+			streamCheckers.emplace_back(checker);
+		}
+	}
 	if(programInput.size()==0){ // No input
-		close(fdwrite);
+		if (fdwrite >= 0) {
+			close(fdwrite);
+		}
+		fdwrite = -1;
+	} else if (programInput.size() > PIPEBUFSIZE && ! lineInput) {
+		// Large inputs in fewer writes, limited by /proc/sys/fs/pipe-max-size
+		fcntl(fdwrite, F_SETPIPE_SZ, (int) min(programInput.size(), (size_t) MAXPIPEBUFSIZE));
 	}
-	programOutputBefore = "";
-	programOutputAfter = "";
+	size_t maxOutput = limits.output ? limits.output : MAXOUTPUT;
+	programOutputBefore.setCapacity(maxOutput);
+	programOutputAfter.setCapacity(maxOutput);
+	// Without pidfd the end of the program is checked every 5ms
+	int pidfd = Tools::pidfdOpen(pid);
+	// The size of an output written to a file is checked every 20ms
+	bool fileOutput = fdoutput >= 0 && output.size() > 0;
+	const int maxWait = pidfd < 0 ? 5 : fileOutput ? 20 : 1000;
+	struct stat outputInfo;
 	pid_t pidr;
 	int status;
+	double mismatchTime = 0; // When the output stopped matching
 	exitCode = std::numeric_limits<int>::min();
-	while ((pidr = waitpid(pid, &status, WNOHANG | WUNTRACED)) == 0) {
-		readWrite(fdread, fdwrite);
-		usleep(5000);
+	while ((pidr = wait4(pid, &status, WNOHANG | WUNTRACED, &usage)) == 0) {
+		// Blocks until there is something to do, the program ends or the timeout expires
+		double end = mismatchTime > 0 ? min(start + timeout, mismatchTime + EARLYSTOPWAIT)
+				: start + timeout;
+		int waitms = (int) ceil((end - Timer::now()) * 1000);
+		readWrite(fdread, fdwrite, pidfd, max(min(waitms, maxWait), 0));
+		if (outputMismatch && mismatchTime == 0) {
+			mismatchTime = Timer::now();
+		} else if (outputMismatch && Timer::now() - mismatchTime >= EARLYSTOPWAIT) {
+			break;
+		}
+		if (fileOutput && fstat(fdoutput, &outputInfo) == 0
+				&& (size_t) outputInfo.st_size > programOutputAfter.getCapacity()) {
+			outputTooLarge = true;
+		}
 		// TERMSIG or timeout or program output too large?
-		if (Stop::isTERMRequested() || (time(NULL) - start) >= timeout
+		if (Stop::isTERMRequested() || (Timer::now() - start) >= timeout
 				|| outputTooLarge) {
-			if ((time(NULL) - start) >= timeout) {
+			if ((Timer::now() - start) >= timeout) {
 				programTimeout = true;
 			}
-			kill(pid, SIGTERM); // Send SIGTERM normal termination
-			int otherstatus;
-			usleep(5000);
-			if (waitpid(pid, &otherstatus, WNOHANG | WUNTRACED) == pid) {
-				break;
-			}
-			if (kill(pid, SIGQUIT) == 0) { // Kill
-				break;
-			}
+			break;
 		}
 	}
+	duration = Timer::now() - start;
+	bool mismatchStop = outputMismatch && pidr == 0; // Stopped by the evaluator
 	if (pidr == pid) {
-		if (WIFSIGNALED(status)) {
-			int signal = WTERMSIG(status);
-			executionError = true;
-			sprintf(executionErrorReason,
-					(L->langEvaluate(23)).c_str(), strsignal(
-							signal), signal);
-		}
-		if (WIFEXITED(status)) {
-			exitCode = WEXITSTATUS(status);
+		usageAvailable = true;
+		if (fileOutput && WIFSIGNALED(status) && WTERMSIG(status) == SIGXFSZ) {
+			outputTooLarge = true; // Reached the size limit of its output file
 		} else {
-			executionError = true;
-			strcpy(executionErrorReason,
-					(L->langEvaluate(24)).c_str());
+			setProgramEnd(status);
 		}
 	} else if (pidr != 0) {
 		executionError = true;
 		strcpy(executionErrorReason, (L->langEvaluate(25)).c_str());
 	}
-	readWrite(fdread, fdwrite);
+	// Ends the program if still running and the processes it left in its group
+	bool reaped;
+	struct rusage leaderUsage;
+	strays = Tools::endProcessGroup(pid, leaderUsage, reaped);
+	if (reaped && pidr == 0) { // Ended by the evaluator
+		usage = leaderUsage;
+		usageAvailable = true;
+	}
+	setCgroupUsage(cgroup);
+	cgroup.destroy(); // Ends the descendants that left the group
+	if (pidfd >= 0) {
+		close(pidfd);
+	}
+	// Collects the output pending in the pipe
+	int sizeReadedBefore;
+	do {
+		sizeReadedBefore = sizeReaded;
+		readWrite(fdread, fdwrite, -1, 0);
+	} while (fdread >= 0 && sizeReaded != sizeReadedBefore && ! outputTooLarge);
+	if (fdwrite >= 0) {
+		close(fdwrite);
+	}
+	if (fdread >= 0) {
+		close(fdread);
+	}
+	if (fdoutput >= 0) {
+		loadOutput(fdoutput);
+		close(fdoutput);
+	}
+	if (pidr == pid) { // The output may show the limit exceeded
+		setLimitReason(status);
+	}
+	streamCheckers.clear();
+	outputMismatch = mismatchStop;
 	correctExitCode = isExitCodeTested() && expectedExitCode == exitCode;
-	correctOutput = match(programOutputAfter)
-			     || match(programOutputBefore + programOutputAfter);
+	correctOutput = matchOutput(timeout - duration);
+}
+
+// Runs the case in the persistent program, starting it if needed
+void TestCase::runTest(double timeout, PersistentProcess &process) {
+	if (persistent) {
+		runPersistentTest(timeout, process);
+	} else {
+		int left = process.stop();
+		runTest(timeout);
+		strays += left;
+	}
+}
+
+void TestCase::runPersistentTest(double timeout, PersistentProcess &process) {
+	double start = Timer::now();
+	string key = programToRun + '\n' + programArgs;
+	if (! process.isRunning(key)) {
+		strays += process.stop();
+		pid_t pid;
+		int fdwrite, fdread;
+		if (! startProgram(pid, fdwrite, fdread, process.cgroup)) {
+			return;
+		}
+		process.start(key, pid, fdwrite, fdread);
+	}
+	// The usage of each case is the difference with the usage before it
+	struct rusage before;
+	Tools::procUsage(process.pid, before);
+	process.cgroup.readUsage(before);
+	programInput = input;
+	if (programInput.size() && programInput[programInput.size() - 1] != '\n') {
+		programInput += '\n';
+	}
+	programInput += inputEnd + '\n';
+	programInputSent = 0;
+	size_t maxOutput = limits.output ? limits.output : MAXOUTPUT;
+	programOutputBefore.setCapacity(maxOutput);
+	programOutputAfter.setCapacity(maxOutput);
+	const int maxWait = process.pidfd >= 0 ? 1000 : 5;
+	size_t endPos = string::npos;
+	size_t searchFrom = 0;
+	pid_t pidr;
+	int status;
+	exitCode = std::numeric_limits<int>::min();
+	while ((pidr = wait4(process.pid, &status, WNOHANG | WUNTRACED, &usage)) == 0) {
+		int waitms = (int) ceil((start + timeout - Timer::now()) * 1000);
+		readWrite(process.fdread, process.fdwrite, process.pidfd,
+				max(min(waitms, maxWait), 0), false);
+		// End of case: a line with the outputend= mark
+		const string &caseOutput = programOutputAfter.view();
+		endPos = caseOutput.find(outputEnd, searchFrom);
+		if (endPos != string::npos) {
+			if (caseOutput.find('\n', endPos + outputEnd.size()) != string::npos) {
+				break;
+			}
+			endPos = string::npos;
+		} else if (caseOutput.size() > outputEnd.size()) {
+			searchFrom = caseOutput.size() - outputEnd.size();
+		}
+		if (Stop::isTERMRequested() || (Timer::now() - start) >= timeout
+				|| outputTooLarge) {
+			if ((Timer::now() - start) >= timeout) {
+				programTimeout = true;
+			}
+			break;
+		}
+	}
+	duration = Timer::now() - start;
+	usageAvailable = pidr == process.pid || Tools::procUsage(process.pid, usage);
+	setCgroupUsage(process.cgroup);
+	if (usageAvailable) {
+		Tools::subUsage(usage, before);
+	}
+	if (pidr == process.pid) { // Collects the output pending in the pipe
+		int sizeReadedBefore;
+		do {
+			sizeReadedBefore = sizeReaded;
+			readWrite(process.fdread, process.fdwrite, -1, 0, false);
+		} while (process.fdread >= 0 && sizeReaded != sizeReadedBefore && ! outputTooLarge);
+		endPos = programOutputAfter.view().find(outputEnd, searchFrom);
+		if (endPos != string::npos) {
+			strays += process.stop();
+		}
+	}
+	if (endPos != string::npos) {
+		programOutputAfter.resize(endPos);
+	} else {
+		if (pidr == process.pid) {
+			setProgramEnd(status);
+			setLimitReason(status);
+			strays += process.stop();
+			if (! executionError) {
+				executionError = true;
+				strcpy(executionErrorReason, (L->langEvaluate(43)).c_str());
+			}
+		} else if (pidr != 0) {
+			executionError = true;
+			strcpy(executionErrorReason, (L->langEvaluate(25)).c_str());
+		}
+		strays += process.stop();
+	}
+	correctOutput = matchOutput(timeout - duration);
+	if (! isCorrectResult()) { // The next case starts a new program
+		strays += process.stop();
+	}
 }
 
-bool TestCase::match(string data) {
+// Only the outputs checked by a program of the teacher or only the others
+bool TestCase::match(ParsedOutput &data, bool checkers) {
 	for (size_t i = 0; i < output.size(); i++)
-		if (output[i]->match(data))
+		if ((dynamic_cast<CheckerOutput*>(output[i]) != NULL) == checkers
+				&& output[i]->matchParsed(data))
 			return true;
 	return false;
 }
 
+// The output after the input was sent, or all the output.
+// Checker programs run once, with all the output, in the time left to the case
+bool TestCase::matchOutput(double timeLeft) {
+	static const string none;
+	double start = Timer::now();
+	double checkerTime = min(CHECKERTIMEOUT, max(timeLeft, MINCHECKERTIME));
+	for (size_t i = 0; i < output.size(); i++) {
+		CheckerOutput *checker = dynamic_cast<CheckerOutput*>(output[i]);
+		if (checker != NULL) {
+			checker->setTimeLimit(checkerTime);
+		}
+	}
+	ParsedOutput after(programOutputAfter.view(), none);
+	bool correct = match(after, false);
+	if (! correct && programOutputBefore.empty()) {
+		correct = match(after, true);
+	} else if (! correct) {
+		ParsedOutput all(programOutputBefore.view(), programOutputAfter.view());
+		correct = match(all, false) || match(all, true);
+	}
+	checkDuration = Timer::now() - start;
+	return correct;
+}
+
+/**
+ * Class TimeBudget Definitions
+ */
+
+TimeBudget::TimeBudget(double maxtime, vector<TestCase> &testCases, size_t lanes,
+		double minCaseTime, double maxCaseTime) {
+	this->maxtime = maxtime;
+	this->minCaseTime = minCaseTime;
+	this->maxCaseTime = maxCaseTime;
+	this->lanes = lanes;
+	pendingCases = 0;
+	pendingRequested = 0;
+	for (size_t i = 0; i < testCases.size(); i++) {
+		if (testCases[i].getTimeout() > 0) {
+			pendingRequested += testCases[i].getTimeout();
+		} else {
+			pendingCases++;
+		}
+	}
+	used = 0;
+	nruns = 0;
+	ntimeouts = 0;
+}
+
+// Not worth starting a program with less than 50ms
+bool TimeBudget::exhausted() {
+	return maxtime - Timer::elapsedTime() < 0.05;
+}
+
+// Returns the timeout of the next case to run, requested is its timeout= value or 0
+double TimeBudget::allocate(double requested) {
+	lock_guard<mutex> lock(budgetMutex);
+	double remaining = maxtime - Timer::elapsedTime();
+	double caseTime;
+	if (requested > 0) {
+		pendingRequested -= requested;
+		caseTime = requested;
+	} else {
+		// Each lane runs its share of the pending cases one after another
+		size_t casesPerLane = (pendingCases + lanes - 1) / lanes;
+		double available = remaining - pendingRequested / lanes;
+		caseTime = available / casesPerLane;
+		pendingCases--;
+		if (caseTime < minCaseTime) {
+			caseTime = minCaseTime;
+		}
+		if (maxCaseTime > 0 && caseTime > maxCaseTime) {
+			caseTime = maxCaseTime;
+		}
+	}
+	return max(min(caseTime, remaining), 0.0);
+}
+
+void TimeBudget::release(double duration, bool timeout) {
+	lock_guard<mutex> lock(budgetMutex);
+	used += duration;
+	nruns++;
+	if (timeout) {
+		ntimeouts++;
+	}
+}
+
+// Only when the share of the cases is limited, the students see it
+void TimeBudget::report() {
+	lock_guard<mutex> lock(budgetMutex);
+	if (minCaseTime <= 0 && maxCaseTime <= 0) {
+		return;
+	}
+	printf((L->langEvaluate(42)).c_str(), Timer::elapsedTime(), maxtime,
+			used, nruns, ntimeouts);
+}
+
+/**
+ * Class CaseHistory Definitions
+ * File format, a line by case: duration runs failures description
+ */
+
+void CaseHistory::load(const string &fname) {
+	vector<string> lines = Tools::splitLines(Tools::readFile(fname));
+	for (size_t i = 0; i < lines.size(); i++) {
+		Entry entry;
+		int pos = 0;
+		if (sscanf(lines[i].c_str(), "%lf %u %u %n", &entry.duration,
+				&entry.runs, &entry.failures, &pos) == 3 && pos > 0) {
+			entries[lines[i].substr(pos)] = entry;
+		}
+	}
+}
+
+// Writes a new file and renames it, concurrent evaluations never see a partial file
+void CaseHistory::save(const string &fname) {
+	string tmp = fname + ".tmp" + to_string(getpid());
+	FILE *f = fopen(tmp.c_str(), "w");
+	if (f == NULL) {
+		return;
+	}
+	for (map<string, Entry>::iterator it = entries.begin(); it != entries.end(); ++it) {
+		fprintf(f, "%.6f %u %u %s\n", it->second.duration, it->second.runs,
+				it->second.failures, it->first.c_str());
+	}
+	if (fclose(f) != 0 || rename(tmp.c_str(), fname.c_str()) != 0) {
+		remove(tmp.c_str());
+	}
+}
+
+void CaseHistory::record(const string &description, double duration, bool failed) {
+	if (description.find('\n') != string::npos) {
+		return;
+	}
+	map<string, Entry>::iterator it = entries.find(description);
+	if (it == entries.end()) {
+		Entry entry = {duration, 1, failed ? 1u : 0u};
+		entries[description] = entry;
+		return;
+	}
+	Entry &entry = it->second;
+	// Recent runs weigh more, the program of the student changes
+	entry.duration = entry.duration * 0.7 + duration * 0.3;
+	entry.runs++;
+	if (failed) {
+		entry.failures++;
+	}
+}
+
+double CaseHistory::getDuration(const string &description, double defaultvalue) {
+	map<string, Entry>::iterator it = entries.find(description);
+	return it == entries.end() ? defaultvalue : it->second.duration;
+}
+
+double CaseHistory::getFailureRate(const string &description, double defaultvalue) {
+	map<string, Entry>::iterator it = entries.find(description);
+	if (it == entries.end() || it->second.runs == 0) {
+		return defaultvalue;
+	}
+	return (double) it->second.failures / it->second.runs;
+}
+
+/**
+ * Class TestCasePool Definitions
+ */
+
+TestCasePool::TestCasePool(vector<TestCase> &testCases, const vector<size_t> &runOrder, TimeBudget &budget)
+		:testCases(testCases), runOrder(runOrder), states(testCases.size(), pending), budget(budget) {
+	nextCase = 0;
+	nconsumed = 0;
+	stopping = false;
+	strays = 0;
+}
+
+TestCasePool::~TestCasePool() {
+	stop();
+}
+
+void TestCasePool::start(size_t nworkers) {
+	for (size_t i = 0; i < nworkers; i++) {
+		workers.push_back(thread(&TestCasePool::work, this));
+	}
+}
+
+void TestCasePool::work() {
+	PersistentProcess process;
+	while (true) {
+		size_t first, last;
+		{
+			unique_lock<mutex> lock(poolMutex);
+			if (nextCase >= testCases.size()) {
+				return;
+			}
+			first = nextCase;
+			last = first + 1;
+			while (last < runOrder.size() && runOrder[last] == runOrder[last - 1] + 1
+					&& testCases[runOrder[last]].sharesProcessWith(testCases[runOrder[last - 1]])) {
+				last++;
+			}
+			nextCase = last;
+		}
+		for (size_t k = first; k < last; k++) {
+			size_t i = runOrder[k];
+			double caseTimeout;
+			{
+				unique_lock<mutex> lock(poolMutex);
+				if (stopping || Stop::isTERMRequested() || budget.exhausted()) {
+					states[i] = notRun;
+					finished.push_back(i);
+					caseFinished.notify_all();
+					continue;
+				}
+				states[i] = running;
+				caseTimeout = budget.allocate(testCases[i].getTimeout());
+			}
+			testCases[i].runTest(caseTimeout, process);
+			budget.release(testCases[i].getDuration() + testCases[i].getCheckDuration(),
+					testCases[i].isTimeout());
+			{
+				unique_lock<mutex> lock(poolMutex);
+				states[i] = done;
+				finished.push_back(i);
+				caseFinished.notify_all();
+			}
+		}
+		strays += process.stop();
+	}
+}
+
+int TestCasePool::getStrays() {
+	return strays;
+}
+
+// Returns the next case done or not run, in the order they finish
+size_t TestCasePool::waitNext(CaseState &state) {
+	unique_lock<mutex> lock(poolMutex);
+	caseFinished.wait(lock, [this]{
+		return nconsumed < finished.size();
+	});
+	size_t i = finished[nconsumed++];
+	state = states[i];
+	return i;
+}
+
+// Cases not started yet are not run. The running ones end normally
+void TestCasePool::requestStop() {
+	unique_lock<mutex> lock(poolMutex);
+	stopping = true;
+}
+
+// Cases not started yet are not run. Waits for the running ones.
+void TestCasePool::stop() {
+	requestStop();
+	for (size_t i = 0; i < workers.size(); i++) {
+		workers[i].join();
+	}
+	workers.clear();
+}
+
 /**
  * Class Evaluation Definitions
  */
 
 Evaluation::Evaluation() {
+	jobs = 1;
+	failFast = false;
+	maxTimeouts = 0;
+	minCaseTime = 0;
+	maxCaseTime = 0;
 	grade = 0;
 	ncomments = 0;
 	nerrors = 0;
 	nruns = 0;
+	nfailedNotRun = 0;
 	noGrade = true;
 }
 
@@ -2284,9 +5107,21 @@ void Evaluation::addTestCase(Case &caso) {
 	if ( caso.getVariation().size() && caso.getVariation() != variation ) {
 		return;
 	}
-	testCases.push_back(TestCase(testCases.size() + 1, caso.getInput(), caso.getOutput(),
+	// With a checker the outputs are expected outputs for it, not parsed
+	static const vector<string> none;
+	testCases.push_back(TestCase(testCases.size() + 1, caso.getInput(),
+			caso.getChecker().size() ? none : caso.getOutput(),
 			caso.getCaseDescription(), caso.getGradeReduction(), caso.getFailMessage(),
-			caso.getProgramToRun(), caso.getProgramArgs(), caso.getExpectedExitCode() ));
+			caso.getProgramToRun(), caso.getProgramArgs(), caso.getExpectedExitCode(),
+			caso.getTimeout() ));
+	testCases.back().setLimits(caso.getLimits());
+	testCases.back().setInputFile(caso.getInputFile());
+	if (caso.getChecker().size()) {
+		testCases.back().setChecker(caso.getChecker(), caso.getOutput());
+	}
+	if (caso.isPersistent()) {
+		testCases.back().setPersistent(caso.getInputEnd(), caso.getOutputEnd());
+	}
 }
 
 void Evaluation::removeLastNL(string &s) {
@@ -2295,6 +5130,22 @@ void Evaluation::removeLastNL(string &s) {
 	}
 }
 
+// Persistent programs need the end of case marks
+void Evaluation::setPersistent(Case &caso, int &persistentLine,
+		const string &inputEnd, const string &outputEnd) {
+	if (persistentLine == 0) {
+		return;
+	}
+	if (inputEnd.size() == 0 || outputEnd.size() == 0) {
+		char buf[250];
+		sprintf(buf, (L->langEvaluate(44)).c_str(), persistentLine);
+		addFatalError(buf);
+		persistentLine = 0;
+		return;
+	}
+	caso.setPersistent(inputEnd, outputEnd);
+}
+
 bool Evaluation::cutToEndTag(string &value, const string &endTag) {
 	size_t pos;
 	if (endTag.size() && (pos = value.find(endTag)) != string::npos) {
@@ -2317,6 +5168,15 @@ void Evaluation::loadTestCases(string fname) {
 	const char *PROGRAMARGS_TAG = "programarguments=";
 	const char *EXPECTEDEXITCODE_TAG = "expectedexitcode=";
 	const char *VARIATION_TAG = "variation=";
+	const char *TIMEOUT_TAG = "timeout=";
+	const char *PERSISTENT_TAG = "persistent=";
+	const char *MAXMEMORY_TAG = "maxmemory=";
+	const char *MAXCPUTIME_TAG = "maxcputime=";
+	const char *MAXFILESIZE_TAG = "maxfilesize=";
+	const char *MAXPROCESSES_TAG = "maxprocesses=";
+	const char *MAXOUTPUT_TAG = "maxoutput=";
+	const char *INPUTFILE_TAG = "inputfile=";
+	const char *CHECKER_TAG = "checker=";
 	enum {
 		regular, ininput, inoutput
 	} state;
@@ -2325,6 +5185,7 @@ void Evaluation::loadTestCases(string fname) {
     remove(fname.c_str());
 	string inputEnd = "";
 	string outputEnd = "";
+	int persistentLine = 0; // Line of persistent= if set
 	Case caso;
 	string output = "";
 	string tag, value;
@@ -2415,12 +5276,59 @@ void Evaluation::loadTestCases(string fname) {
 				caso.setFailMessage(Tools::trim(value));
 			} else if (tag == VARIATION_TAG) {
 				caso.setVariation(value);
+			} else if (tag == TIMEOUT_TAG) {
+				value = Tools::toLower(Tools::trim(value));
+				// A milliseconds value?
+				if( value.size() > 2 && value.substr(value.size() - 2) == "ms" ){
+					caso.setTimeout(atof(value.c_str()) / 1000);
+				}else{
+					caso.setTimeout(atof(value.c_str()));
+				}
+			} else if (tag == MAXMEMORY_TAG || tag == MAXCPUTIME_TAG
+					|| tag == MAXFILESIZE_TAG || tag == MAXPROCESSES_TAG || tag == MAXOUTPUT_TAG) {
+				double limit;
+				value = Tools::trim(value);
+				bool valid = value.size() > 0 && (tag == MAXMEMORY_TAG || tag == MAXFILESIZE_TAG
+						|| tag == MAXOUTPUT_TAG
+						? Tools::convert2Size(value, limit)
+						: Tools::convert2(value, limit) && limit >= 0);
+				if (! valid) {
+					char buf[250];
+					sprintf(buf, (L->langEvaluate(52)).c_str(), i + 1);
+					addFatalError(buf);
+				} else {
+					CaseLimits &limits = caso.getLimits();
+					if (tag == MAXMEMORY_TAG) {
+						limits.memory = (rlim_t) limit;
+					} else if (tag == MAXCPUTIME_TAG) {
+						limits.cputime = (rlim_t) ceil(limit);
+					} else if (tag == MAXFILESIZE_TAG) {
+						limits.filesize = (rlim_t) limit;
+					} else if (tag == MAXOUTPUT_TAG) {
+						limits.output = (size_t) limit;
+					} else {
+						limits.processes = (rlim_t) limit;
+					}
+				}
+			} else if (tag == INPUTFILE_TAG) {
+				inCase = true;
+				caso.setInputFile(Tools::trim(value));
+			} else if (tag == CHECKER_TAG) {
+				caso.setChecker(Tools::trim(value));
+			} else if (tag == PERSISTENT_TAG) {
+				value = Tools::toLower(Tools::trim(value));
+				if (value == "yes" || value == "true" || value == "on" || value == "1") {
+					persistentLine = i + 1;
+				} else {
+					persistentLine = 0;
+				}
 			} else if (tag == INPUT_END_TAG) {
 				inputEnd = Tools::trim(value);
 			} else if (tag == OUTPUT_END_TAG) {
 				outputEnd = Tools::trim(value);
 			} else if (tag == CASE_TAG) {
 				if (inCase) {
+					setPersistent(caso, persistentLine, inputEnd, outputEnd);
 					addTestCase(caso);
 					caso.reset();
 				}
@@ -2441,6 +5349,7 @@ void Evaluation::loadTestCases(string fname) {
 		caso.addOutput(output);
 	}
 	if (inCase) { // Last case => save current.
+		setPersistent(caso, persistentLine, inputEnd, outputEnd);
 		addTestCase(caso);
 	}
 }
@@ -2448,13 +5357,36 @@ void Evaluation::loadTestCases(string fname) {
 bool Evaluation::loadParams() {
 	grademin= Tools::getenv("VPL_GRADEMIN", 0.0);
 	grademax = Tools::getenv("VPL_GRADEMAX", 10);
-	maxtime = (int) Tools::getenv("VPL_MAXTIME", 20);
+	maxtime = Tools::getenv("VPL_MAXTIME", 20);
+	jobs = (int) Tools::getenvOption("VPL_EVAL_JOBS", 1);
+	if (jobs == 0) { // One job per online CPU
+		jobs = sysconf(_SC_NPROCESSORS_ONLN);
+	}
+	if (jobs < 1) {
+		jobs = 1;
+	}
+	minCaseTime = Tools::getenvOption("VPL_EVAL_MINCASETIME", 0.0);
+	maxCaseTime = Tools::getenvOption("VPL_EVAL_MAXCASETIME", 0.0);
+	failFast = Tools::getenvOption("VPL_EVAL_FAILFAST", 0.0) != 0;
+	TestCase::setLineInput(Tools::getenvOption("VPL_EVAL_LINEINPUT", 0.0) != 0);
+	TestCase::setEarlyStop(Tools::getenvOption("VPL_EVAL_EARLYSTOP", 1.0) != 0);
+	TestCase::setFileCapture(Tools::toLower(Tools::trim(
+			Tools::getenvOption("VPL_EVAL_CAPTURE", ""))) == "file");
+	maxTimeouts = (int) Tools::getenvOption("VPL_EVAL_MAXTIMEOUTS", 0.0);
+	historyFile = Tools::trim(Tools::getenvOption("VPL_EVAL_HISTORY", ""));
+	order = Tools::toLower(Tools::trim(Tools::getenvOption("VPL_EVAL_ORDER", "")));
+	resourcesFile = Tools::trim(Tools::getenvOption("VPL_EVAL_RESOURCES", ""));
+	Cgroup::setup(Tools::trim(Tools::getenvOption("VPL_EVAL_CGROUP", "")),
+			(rlim_t) Tools::getenvOption("VPL_MAXMEMORY", 0.0),
+			(rlim_t) Tools::getenvOption("VPL_MAXPROCESSES", 0.0),
+			Tools::getenvOption("VPL_EVAL_CGROUP_CPUS", 1.0));
 	variation = Tools::toLower(Tools::trim(Tools::getenv("VPL_VARIATION","")));
 	noGrade = grademin >= grademax;
 	return true;
 }
 
 void Evaluation::addFatalError(const char *m) {
+	lock_guard<recursive_mutex> lock(commentsMutex);
 	float reduction = grademax - grademin;
 	if (ncomments >= MAXCOMMENTS)
 		ncomments = MAXCOMMENTS - 1;
@@ -2466,6 +5398,113 @@ void Evaluation::addFatalError(const char *m) {
 	grade = grademin;
 }
 
+// Cases run first by the order policy. Cases sharing a persistent program keep together.
+vector<size_t> Evaluation::getRunOrder(float defaultGradeReduction) {
+	vector<size_t> groups; // First case of each group
+	for (size_t i = 0; i < testCases.size(); i++) {
+		if (i == 0 || ! testCases[i].sharesProcessWith(testCases[i - 1])) {
+			groups.push_back(i);
+		}
+	}
+	vector<double> cost(testCases.size()), failure(testCases.size()), value(testCases.size());
+	for (size_t g = 0; g < groups.size(); g++) {
+		size_t first = groups[g];
+		size_t last = g + 1 < groups.size() ? groups[g + 1] : testCases.size();
+		double gr = 0;
+		for (size_t i = first; i < last; i++) {
+			const string &description = testCases[i].getCaseDescription();
+			cost[first] += history.getDuration(description, 0);
+			failure[first] = max(failure[first], history.getFailureRate(description, 0));
+			float caseGr = testCases[i].getGradeReduction();
+			gr += caseGr == std::numeric_limits<float>::min() ? defaultGradeReduction : caseGr;
+		}
+		value[first] = gr / max(cost[first], 0.001);
+	}
+	if (order == "cost") {
+		stable_sort(groups.begin(), groups.end(), [&cost](size_t a, size_t b) {
+			return cost[a] < cost[b];
+		});
+	} else if (order == "failure") {
+		stable_sort(groups.begin(), groups.end(), [&failure, &cost](size_t a, size_t b) {
+			return failure[a] > failure[b] || (failure[a] == failure[b] && cost[a] < cost[b]);
+		});
+	} else if (order == "value") {
+		stable_sort(groups.begin(), groups.end(), [&value](size_t a, size_t b) {
+			return value[a] > value[b];
+		});
+	}
+	vector<size_t> runOrder;
+	for (size_t g = 0; g < groups.size(); g++) {
+		size_t i = groups[g];
+		do {
+			runOrder.push_back(i++);
+		} while (i < testCases.size() && testCases[i].sharesProcessWith(testCases[i - 1]));
+	}
+	return runOrder;
+}
+
+// Lists the cases not evaluated when the evaluation stops.
+// If failed, they take off their grade reduction as failed cases
+void Evaluation::addNotRunCases(vector<size_t> cases, const string &reason, bool failed,
+		float defaultGradeReduction) {
+	lock_guard<recursive_mutex> lock(commentsMutex);
+	notRunReason = reason;
+	notRunCases = "";
+	bool listFull = false;
+	sort(cases.begin(), cases.end());
+	for (size_t i : cases) {
+		if (failed) {
+			applyGradeReduction(testCases[i], defaultGradeReduction);
+			nfailedNotRun++;
+		}
+		if (listFull) {
+			continue;
+		}
+		if (notRunCases.size() > MAXCOMMENTSLENGTH / 2) {
+			notRunCases += "...\n";
+			listFull = true;
+			continue;
+		}
+		notRunCases += testCases[i].getCommentTitle();
+	}
+}
+
+// Takes off the grade reduction of a failed case, its own or the default one
+void Evaluation::applyGradeReduction(TestCase &testCase, float defaultGradeReduction) {
+	lock_guard<recursive_mutex> lock(commentsMutex);
+	float gr = testCase.getGradeReduction();
+	if (gr == std::numeric_limits<float>::min())
+		testCase.setGradeReductionApplied(defaultGradeReduction);
+	else
+		testCase.setGradeReductionApplied(gr);
+	grade -= testCase.getGradeReductionApplied();
+	if (grade < grademin) {
+		grade = grademin;
+	}
+}
+
+// Adds the result of a case run, the results are reported in case order
+void Evaluation::reportCase(size_t i, bool announce) {
+	TestCase &testCase = testCases[i];
+	if (announce) {
+		printf((L->langEvaluate(28)).c_str(), (unsigned long) i+1, (unsigned long)testCases.size(), testCase.getCaseDescription().c_str());
+	}
+	runCases.push_back(i);
+	if (testCase.isCorrectResult()) {
+		return;
+	}
+	lock_guard<recursive_mutex> lock(commentsMutex);
+	if(ncomments<MAXCOMMENTS){
+		strncpy(titles[ncomments], testCase.getCommentTitle().c_str(),
+				MAXCOMMENTSTITLELENGTH);
+		strncpy(titlesGR[ncomments], testCase.getCommentTitle(true).c_str(),
+				MAXCOMMENTSTITLELENGTH);
+		strncpy(comments[ncomments], testCase.getComment().c_str(),
+				MAXCOMMENTSLENGTH);
+		ncomments++;
+	}
+}
+
 void Evaluation::runTests() {
 	if (testCases.size() == 0) {
 		return;
@@ -2476,45 +5515,147 @@ void Evaluation::runTests() {
 	}
 	nerrors = 0;
 	nruns = 0;
+	nfailedNotRun = 0;
+	runCases.clear();
 	grade = grademax;
 	float defaultGradeReduction = (grademax - grademin) / testCases.size();
-	int timeout = maxtime / testCases.size();
-	for (size_t i = 0; i < testCases.size(); i++) {
-		printf((L->langEvaluate(28)).c_str(), (unsigned long) i+1, (unsigned long)testCases.size(), testCases[i].getCaseDescription().c_str());
-		if (timeout <= 1 || Timer::elapsedTime() >= maxtime) {
-			grade = grademin;
-			addFatalError((L->langEvaluate(27)).c_str());
-			return;
-		}
-		if (maxtime - Timer::elapsedTime() < timeout) { // Try to run last case
-			timeout = maxtime - Timer::elapsedTime();
+	size_t nworkers = min((size_t) jobs, testCases.size());
+	if (historyFile.size()) {
+		history.load(historyFile);
+	}
+	vector<size_t> runOrder = getRunOrder(defaultGradeReduction);
+	bool reordered = ! is_sorted(runOrder.begin(), runOrder.end());
+	TimeBudget budget(maxtime, testCases, nworkers, minCaseTime, maxCaseTime);
+	TestCasePool pool(testCases, runOrder, budget);
+	PersistentProcess process;
+	int consecutiveTimeouts = 0;
+	bool usePool = nworkers > 1 || reordered;
+	if (usePool) { // The pool runs the cases in run order
+		pool.start(nworkers);
+	}
+	bool stopped = false; // No more cases start, the running ones end
+	string stopReason;
+	bool stopFailed = false;
+	vector<size_t> notRun; // Cases not started after stopping
+	vector<bool> finished(testCases.size(), false);
+	size_t nextReport = 0; // Cases finish in any order, they are reported in case order
+	for (size_t n = 0; n < testCases.size(); n++) {
+		size_t i = n;
+		if (usePool) {
+			TestCasePool::CaseState state;
+			i = pool.waitNext(state);
+			if (state == TestCasePool::notRun) {
+				if (stopped) {
+					notRun.push_back(i);
+					continue;
+				}
+				if (Stop::isTERMRequested())
+					break;
+				grade = grademin;
+				addFatalError((L->langEvaluate(27)).c_str());
+				break;
+			}
+		} else {
+			if (stopped) {
+				notRun.push_back(i);
+				continue;
+			}
+			printf((L->langEvaluate(28)).c_str(), (unsigned long) i+1, (unsigned long)testCases.size(), testCases[i].getCaseDescription().c_str());
+			if (budget.exhausted()) {
+				grade = grademin;
+				addFatalError((L->langEvaluate(27)).c_str());
+				break;
+			}
+			testCases[i].runTest(budget.allocate(testCases[i].getTimeout()), process);
+			budget.release(testCases[i].getDuration() + testCases[i].getCheckDuration(),
+					testCases[i].isTimeout());
 		}
-		testCases[i].runTest(timeout);
 		nruns++;
+		history.record(testCases[i].getCaseDescription(), testCases[i].getDuration(),
+				! testCases[i].isCorrectResult());
 		if (!testCases[i].isCorrectResult()) {
 			if (Stop::isTERMRequested())
 				break;
-			float gr = testCases[i].getGradeReduction();
-			if (gr == std::numeric_limits<float>::min())
-				testCases[i].setGradeReductionApplied(defaultGradeReduction);
-			else
-				testCases[i].setGradeReductionApplied(gr);
-			grade -= testCases[i].getGradeReductionApplied();
-			if (grade < grademin) {
-				grade = grademin;
-			}
+			applyGradeReduction(testCases[i], defaultGradeReduction);
 			nerrors++;
-			if(ncomments<MAXCOMMENTS){
-				strncpy(titles[ncomments], testCases[i].getCommentTitle().c_str(),
-						MAXCOMMENTSTITLELENGTH);
-				strncpy(titlesGR[ncomments], testCases[i].getCommentTitle(true).c_str(),
-						MAXCOMMENTSTITLELENGTH);
-				strncpy(comments[ncomments], testCases[i].getComment().c_str(),
-						MAXCOMMENTSLENGTH);
-				ncomments++;
+		}
+		finished[i] = true;
+		for (; nextReport < testCases.size() && finished[nextReport]; nextReport++) {
+			reportCase(nextReport, usePool);
+		}
+		// Stop conditions follow the order the cases finish
+		consecutiveTimeouts = testCases[i].isTimeout() ? consecutiveTimeouts + 1 : 0;
+		if (!stopped && n + 1 < testCases.size()) {
+			char reason[100];
+			if (failFast && ! noGrade && grade <= grademin) {
+				strcpy(reason, (L->langEvaluate(45)).c_str());
+				stopFailed = false; // Cases that can not lower the grade are not failed
+			} else if (maxTimeouts > 0 && consecutiveTimeouts >= maxTimeouts) {
+				sprintf(reason, (L->langEvaluate(46)).c_str(), consecutiveTimeouts);
+				stopFailed = true;
+			} else {
+				continue;
 			}
+			stopped = true;
+			stopReason = reason;
+			pool.requestStop();
+		}
+	}
+	for (; nextReport < testCases.size(); nextReport++) { // Those after the cases not run
+		if (finished[nextReport]) {
+			reportCase(nextReport, usePool);
+		}
+	}
+	if (notRun.size()) {
+		addNotRunCases(notRun, stopReason, stopFailed, defaultGradeReduction);
+	}
+	int strays = process.stop();
+	pool.stop();
+	strays += pool.getStrays() + Tools::endChildren();
+	for (size_t i = 0; i < testCases.size(); i++) {
+		strays += testCases[i].getStrays();
+	}
+	budget.report();
+	if (strays > 0) {
+		printf((L->langEvaluate(54)).c_str(), strays);
+	}
+	if (historyFile.size()) {
+		history.save(historyFile);
+	}
+	if (resourcesFile.size()) {
+		saveResources();
+	}
+}
+
+// Writes a tab separated line for each case run, times in seconds and memory in KB
+void Evaluation::saveResources() {
+	FILE *f = fopen(resourcesFile.c_str(), "w");
+	if (f == NULL) {
+		return;
+	}
+	fprintf(f, "#case\tduration\tuser\tsystem\tmaxrss\tminflt\tmajflt\tnvcsw\tnivcsw\t"
+			"exitcode\ttimeout\tpassed\tstrays\tdescription\n");
+	for (size_t i : runCases) {
+		TestCase &tc = testCases[i];
+		const struct rusage &usage = tc.getUsage();
+		fprintf(f, "%lu\t%.6f\t", (unsigned long) i + 1, tc.getDuration());
+		if (tc.isUsageAvailable()) {
+			fprintf(f, "%.6f\t%.6f\t%ld\t%ld\t%ld\t%ld\t%ld\t",
+					Tools::seconds(usage.ru_utime), Tools::seconds(usage.ru_stime),
+					usage.ru_maxrss, usage.ru_minflt, usage.ru_majflt,
+					usage.ru_nvcsw, usage.ru_nivcsw);
+		} else {
+			fprintf(f, "-\t-\t-\t-\t-\t-\t-\t");
 		}
+		if (tc.getExitCode() == std::numeric_limits<int>::min()) {
+			fprintf(f, "-\t");
+		} else {
+			fprintf(f, "%d\t", tc.getExitCode());
+		}
+		fprintf(f, "%d\t%d\t%d\t%s\n", tc.isTimeout() ? 1 : 0, tc.isCorrectResult() ? 1 : 0,
+				tc.getStrays(), Tools::trim(tc.getCaseDescription()).c_str());
 	}
+	fclose(f);
 }
 
 // WIP
@@ -2541,12 +5682,19 @@ void Evaluation::outputEvaluationEnhance() {
 		}
 		printf("--|>\n");
 	}
+	if ( notRunCases.size() > 0 ) {
+		printf("\n<|--\n");
+		printf((L->langEvaluate(47)).c_str(), notRunReason.c_str());
+		printf("%s", notRunCases.c_str());
+		printf("--|>\n");
+	}
 	int passed = nruns - nerrors;
-	if ( nruns > 0 ) {
+	int counted = nruns + nfailedNotRun;
+	if ( counted > 0 ) {
 		printf("%s",(L->langEvaluate(32)).c_str());
 		printf("%s",(L->langEvaluate(33)).c_str());
 		printf((L->langEvaluate(34)).c_str(),
-				nruns, nruns==1?stest[0]:stest[1],
+				counted, counted==1?stest[0]:stest[1],
 				passed, passed==1?stest[0]:stest[1]); // Taken from Dominique Thiebaut
 		printf("%s",(L->langEvaluate(33)).c_str());
 		printf("\n--|>\n");
@@ -2563,6 +5711,7 @@ void Evaluation::outputEvaluationEnhance() {
 }
 
 void Evaluation::outputEvaluation() {
+	lock_guard<recursive_mutex> lock(commentsMutex);
 	const char* stest[] = {" test", "tests"};
 	if (testCases.size() == 0) {
 		printf("<|--\n");
@@ -2585,13 +5734,20 @@ void Evaluation::outputEvaluation() {
 		}
 		printf("--|>\n");
 	}
+	if ( notRunCases.size() > 0 ) {
+		printf("\n<|--\n");
+		printf("-Test cases not run (%s)\n", notRunReason.c_str());
+		printf("%s", notRunCases.c_str());
+		printf("--|>\n");
+	}
 	int passed = nruns - nerrors;
-	if ( nruns > 0 ) {
+	int counted = nruns + nfailedNotRun;
+	if ( counted > 0 ) {
 		printf("\n<|--\n");
 		printf("-Summary of tests\n");
 		printf(">+------------------------------+\n");
 		printf(">| %2d %s run/%2d %s passed |\n",
-				nruns, nruns==1?stest[0]:stest[1],
+				counted, counted==1?stest[0]:stest[1],
 				passed, passed==1?stest[0]:stest[1]); // Taken from Dominique Thiebaut
 		printf(">+------------------------------+\n");
 		printf("\n--|>\n");
@@ -2671,7 +5827,10 @@ int main(int argc, char *argv[], char **envp) {
 	}
 
 	Timer::start();
+	// Orphans of the programs become children of the evaluator, which can end them
+	prctl(PR_SET_CHILD_SUBREAPER, 1);
 	TestCase::setEnvironment((const char**) envp);
+	NumberScanner::init();
 	setSignalsCatcher();
 	Evaluation* obj = Evaluation::getSinglenton();
 	obj->loadParams();
@@ -0,0 +1,7 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^-Test 2: Slow" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Program timeout" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Grade :=>> 6.67$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,26 @@
+#!/bin/bash
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+echo "First?"
+read A
+echo "Second?"
+read B
+if [ "$A" == "5" ] ; then
+	echo "$A $B $((A + B))"
+else
+	echo "$A $B $((A * B))"
+fi
+ENDOFSCRIPT
+chmod +x vpl_execution
+cat > product_checker.sh << "ENDOFSCRIPT"
+#!/bin/bash
+read A < "$1"
+echo "run $A" >> checker.log
+if [ "$A" == "9" ] ; then
+	sleep 5
+	echo "finished $A" >> checker.log
+fi
+read X Y P < <(tail -n 1 "$3")
+[ $((X * Y)) == "$P" ]
+ENDOFSCRIPT
+chmod +x product_checker.sh
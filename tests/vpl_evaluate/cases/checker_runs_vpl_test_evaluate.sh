@@ -0,0 +1,10 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+# The checker runs once by case, in the time left to the case
+[ "$(echo $(cat checker.log))" == "run 3 run 5 run 9" ] || exit 1
+grep -e "^-Test 1" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "^-Test 2" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^The checker program failed: Killed" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Grade :=>> 3.33$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,26 @@
+#!/bin/bash
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A B
+if [ "$A" == "factors" ] ; then
+	echo "2 $((B / 2))"
+else
+	echo "c b a"
+fi
+ENDOFSCRIPT
+chmod +x vpl_execution
+cat > factors_checker.sh << "ENDOFSCRIPT"
+#!/bin/bash
+read A N < "$1"
+read X Y <&5
+if [ $((X * Y)) != $N ] ; then
+	echo "$X*$Y is not $N"
+	exit 1
+fi
+ENDOFSCRIPT
+chmod +x factors_checker.sh
+cat > words_checker.sh << "ENDOFSCRIPT"
+#!/bin/bash
+[ "$(tr ' ' '\n' < "$2" | sort)" == "$(tr ' ' '\n' < "$3" | sort)" ]
+ENDOFSCRIPT
+chmod +x words_checker.sh
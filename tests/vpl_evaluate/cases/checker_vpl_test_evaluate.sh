@@ -0,0 +1,8 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^-Test [13]" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "^2\*3 is not 7$" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^The checker program failed" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Grade :=>> 4$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,7 @@
+#!/bin/bash
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A
+seq 1 $A
+ENDOFSCRIPT
+chmod +x vpl_execution
@@ -0,0 +1,12 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -c -e "^The outputs differ from line" "$VPLTESTOUTPUT" | grep -e "^1$" > /dev/null || exit 1
+grep -e "^The outputs differ from line 4 of the program output" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^5$" "$VPLTESTOUTPUT" >/dev/null || exit 1
+# Only the numbers output shows its first lines
+grep -c -e "^44$" "$VPLTESTOUTPUT" | grep -e "^1$" > /dev/null || exit 1
+grep -e "^1040$" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^2999$" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "Grade :=>> 0$" "$VPLTESTOUTPUT" >/dev/null
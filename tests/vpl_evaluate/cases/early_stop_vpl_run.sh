@@ -0,0 +1,14 @@
+#!/bin/bash
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A
+if [ "$A" == "ok" ] ; then
+	echo "ok"
+	exit 0
+fi
+echo "$A"
+while true ; do
+	sleep 1
+done
+ENDOFSCRIPT
+chmod +x vpl_execution
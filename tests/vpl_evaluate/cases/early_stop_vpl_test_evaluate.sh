@@ -0,0 +1,9 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+N=$(grep -c -e "^Program stopped: its output can not match the expected output" "$VPLTESTOUTPUT")
+[ "$N" == "2" ] || exit 1
+N=$(grep -c -e "^Program timeout" "$VPLTESTOUTPUT")
+[ "$N" == "1" ] || exit 1
+grep -e "Grade :=>> 2.50$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,8 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^-Test cases not run" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^Test 4: Not run 2" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "2 tests run/ 0 tests passed" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Grade :=>> 0$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,11 @@
+#!/bin/bash
+echo "export VPL_EVAL_CAPTURE=file" >> vpl_environment.sh
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A
+if [ "$A" == "0" ] ; then
+	exec yes
+fi
+seq 1 $A
+ENDOFSCRIPT
+chmod +x vpl_execution
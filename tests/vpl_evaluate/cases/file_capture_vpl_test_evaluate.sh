@@ -0,0 +1,9 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+# The program is stopped when its output file reaches the size kept
+[ "$(grep -c -e "^Program output too large (1Kb)" "$VPLTESTOUTPUT")" == "2" ] || exit 1
+grep -e "^Program terminated" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "^-Test [134]" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "Grade :=>> 6$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,14 @@
+#!/bin/bash
+echo "export VPL_EVAL_HISTORY=history.txt" >> vpl_environment.sh
+echo "export VPL_EVAL_ORDER=cost" >> vpl_environment.sh
+cat > history.txt << "ENDOFHISTORY"
+2.000000 3 0 Slow
+0.100000 3 1 Fast
+ENDOFHISTORY
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A
+echo "$A" >> order.log
+echo "$A"
+ENDOFSCRIPT
+chmod +x vpl_execution
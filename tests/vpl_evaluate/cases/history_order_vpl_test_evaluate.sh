@@ -0,0 +1,10 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+[ "$(echo $(cat order.log))" == "c b a" ] || exit 1
+grep -e "^Testing 1/3 : Slow" "$VPLTESTOUTPUT" >/dev/null || exit 1
+[ "$(echo $(grep -e "^Testing" "$VPLTESTOUTPUT" | cut -d " " -f 2))" == "1/3 2/3 3/3" ] || exit 1
+grep -e " 4 0 Slow$" history.txt >/dev/null || exit 1
+grep -e " 1 0 New$" history.txt >/dev/null || exit 1
+grep -e "Grade :=>>10$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,7 @@
+#!/bin/bash
+seq 1 10000 > numbers.txt
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+awk '{ s += $1 } END { print s + 0 }'
+ENDOFSCRIPT
+chmod +x vpl_execution
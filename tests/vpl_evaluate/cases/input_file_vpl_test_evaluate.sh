@@ -0,0 +1,8 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^-Test 1" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "^File numbers.txt (48894 bytes)" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^Can not open the input file missing.txt" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Grade :=>> 3.33$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,14 @@
+#!/bin/bash
+echo "export VPL_EVAL_LINEINPUT=1" >> vpl_environment.sh
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+while true ; do
+   read A
+   if [ "$?" != "0" ] ; then
+  	  break
+   else
+   	  echo "$A"      
+   fi
+done
+ENDOFSCRIPT
+chmod +x vpl_execution
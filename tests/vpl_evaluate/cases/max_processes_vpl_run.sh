@@ -0,0 +1,12 @@
+#!/bin/bash
+echo "export VPL_EVAL_JOBS=4" >> vpl_environment.sh
+# maxprocesses= limits the processes of each case, not those of the user
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A
+sleep 0.3 &
+sleep 0.3 &
+wait
+echo "$A"
+ENDOFSCRIPT
+chmod +x vpl_execution
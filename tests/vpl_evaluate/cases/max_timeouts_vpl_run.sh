@@ -0,0 +1,9 @@
+#!/bin/bash
+echo "export VPL_EVAL_MAXTIMEOUTS=2" >> vpl_environment.sh
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A
+sleep $A
+echo "$A"
+ENDOFSCRIPT
+chmod +x vpl_execution
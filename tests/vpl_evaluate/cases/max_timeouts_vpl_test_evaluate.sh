@@ -0,0 +1,8 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^-Test cases not run (2 consecutive timeouts)" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^Test 3: Fast" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "3 tests run/ 0 tests passed" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Grade :=>> 0$" "$VPLTESTOUTPUT" >/dev/null
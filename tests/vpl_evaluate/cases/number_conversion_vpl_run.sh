@@ -0,0 +1,108 @@
+#!/bin/bash
+# Compares the conversion of numbers without a stream (Tools::parseNumber)
+# with the stream conversion convert2 falls back to
+cat > number_conversion.cpp << "ENDOFSOURCE"
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+#define main vpl_main
+#include "vpl_evaluate.cpp.save" // Renamed while vpl_run.sh runs
+#undef main
+
+static bool streamConvert(const string &str, double &data) {
+	if (str == ".") {
+		return false;
+	}
+	stringstream conv(str);
+	conv >> data;
+	return conv.eof();
+}
+
+static bool streamConvert(const string &str, long int &data) {
+	stringstream conv(str);
+	conv >> data;
+	return conv.eof();
+}
+
+static bool sameDouble(double a, double b) {
+	return memcmp(&a, &b, sizeof(a)) == 0 || (a != a && b != b);
+}
+
+// Number of strings converted differently, the first ones are shown
+static int compare(const vector<string> &corpus) {
+	int differences = 0;
+	for (size_t i = 0; i < corpus.size(); i++) {
+		const string &s = corpus[i];
+		double expectedDouble = 12345, foundDouble = 12345;
+		bool expected = streamConvert(s, expectedDouble);
+		bool found = Tools::convert2(s, foundDouble);
+		double fastDouble;
+		bool fast = Tools::parseNumber(s, fastDouble);
+		if (expected != found || (expected && ! sameDouble(expectedDouble, foundDouble))) {
+			if (differences++ < 10) {
+				printf("double [%s] stream %d %.17g %s %d %.17g\n", s.c_str(), expected, expectedDouble,
+						fast ? "parseNumber" : "convert2", found, foundDouble);
+			}
+		}
+		long int expectedLong = 12345, foundLong = 12345;
+		expected = streamConvert(s, expectedLong);
+		found = Tools::convert2(s, foundLong);
+		if (expected != found || (expected && expectedLong != foundLong)) {
+			if (differences++ < 10) {
+				printf("long [%s] stream %d %ld convert2 %d %ld\n", s.c_str(), expected, expectedLong,
+						found, foundLong);
+			}
+		}
+	}
+	return differences;
+}
+
+int main() {
+	string kind;
+	unsigned seed = 0;
+	int count = 0;
+	cin >> kind >> seed >> count;
+	mt19937 generator(seed);
+	vector<string> corpus;
+	if (kind == "edge") {
+		corpus = {"", "-", "+", ".", "1.", "+.5", "-.5", ".5", "1e5", "1e", "1e+", "--1", "+-1", "-+1",
+				"1.2.3", "1e400", "-1e400", "1e-400", "99999999999999999999", "-99999999999999999999",
+				"-0", "+0", "1-2", "1E5", "00012", ".e1", "5.e-3", "9223372036854775807",
+				"-9223372036854775808", "9223372036854775808", "0.1", "3.14159265358979323846",
+				"1e308", "2.2250738585072014e-308", "4.9e-324", "+1", "+12", "12+", "1..2", "e", "E5",
+				"0e0", "-0.0", "0x10", "inf", "nan", " 1", "1 "};
+	} else if (kind == "random") { // Signs, digits, dots and exponents
+		const char chars[] = "0123456789+-.eE";
+		for (int i = 0; i < count; i++) {
+			string s;
+			int size = generator() % 10 + 1;
+			for (int j = 0; j < size; j++) {
+				s += chars[generator() % (sizeof(chars) - 1)];
+			}
+			corpus.push_back(s);
+		}
+	} else if (kind == "printf") { // Values as programs write them
+		const char *formats[] = {"%g", "%.17g", "%e", "%f", "%.3f", "%E", "%+.10g"};
+		for (int i = 0; i < count; i++) {
+			char buf[64];
+			double value = ldexp((double) (generator() % 100000000) / 1e4, (int) (generator() % 200) - 100);
+			snprintf(buf, sizeof(buf), formats[generator() % 7], generator() % 2 ? value : -value);
+			corpus.push_back(buf);
+			long int integer = (long int) generator() * (long int) generator();
+			snprintf(buf, sizeof(buf), "%ld", generator() % 2 ? integer : -integer);
+			corpus.push_back(buf);
+		}
+	}
+	printf("%d differences\n", compare(corpus));
+	return 0;
+}
+ENDOFSOURCE
+g++ number_conversion.cpp -std=c++17 -O2 -pthread -lm -lutil -o number_conversion
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+./number_conversion
+ENDOFSCRIPT
+chmod +x vpl_execution
@@ -0,0 +1,6 @@
+#!/bin/bash
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+cat
+ENDOFSCRIPT
+chmod +x vpl_execution
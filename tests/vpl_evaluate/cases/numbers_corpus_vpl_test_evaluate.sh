@@ -0,0 +1,8 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^-Test [1-5]" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "^-Test 6" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^-Test 7" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Grade :=>> 7.14$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,15 @@
+#!/bin/bash
+echo "export VPL_EVAL_HISTORY=history.txt" >> vpl_environment.sh
+echo "export VPL_EVAL_ORDER=cost" >> vpl_environment.sh
+echo "export VPL_EVAL_FAILFAST=1" >> vpl_environment.sh
+cat > history.txt << "ENDOFHISTORY"
+2.000000 3 0 Slow
+0.200000 3 0 Wrong
+0.100000 3 0 AlsoWrong
+ENDOFHISTORY
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A
+echo "$A"
+ENDOFSCRIPT
+chmod +x vpl_execution
@@ -0,0 +1,9 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+# AlsoWrong ran before Wrong stopped the evaluation, it is not listed as not run
+sed -n '/^-Test cases not run/,$p' "$VPLTESTOUTPUT" | grep -e "AlsoWrong" >/dev/null && exit 1
+grep -e " 4 1 AlsoWrong$" history.txt >/dev/null || exit 1
+grep -e " 4 1 Wrong$" history.txt >/dev/null || exit 1
+grep -e "Grade :=>> 0$" "$VPLTESTOUTPUT" >/dev/null
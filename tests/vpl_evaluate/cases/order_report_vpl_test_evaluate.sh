@@ -0,0 +1,10 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+# The slow case runs last, the cases are reported in case order
+[ "$(echo $(cat order.log))" == "b a" ] || exit 1
+[ "$(grep -e "^Testing" "$VPLTESTOUTPUT" | head -n 1)" == "Testing 1/2 : One slow" ] || exit 1
+[ "$(grep -e "^Test [12]: " "$VPLTESTOUTPUT" | head -n 1)" == "Test 1: One slow" ] || exit 1
+[ "$(grep -e "^-Test [12]: " "$VPLTESTOUTPUT" | head -n 1 | cut -d "(" -f 1)" == "-Test 1: One slow " ] || exit 1
+grep -e "Grade :=>> 0$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,8 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^Program output too large (3Kb)" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^Program output too large ([23][0-9][0-9]Kb)" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^-Test 3" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "Grade :=>> 3.33$" "$VPLTESTOUTPUT" >/dev/null
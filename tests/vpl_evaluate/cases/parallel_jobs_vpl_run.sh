@@ -0,0 +1,14 @@
+#!/bin/bash
+echo "export VPL_MAXTIME=3" >> vpl_environment.sh
+echo "export VPL_EVAL_JOBS=4" >> vpl_environment.sh
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A
+if [ "$A" == "1" ] ; then
+	sleep 2
+else
+	sleep 1
+fi
+echo "$A"
+ENDOFSCRIPT
+chmod +x vpl_execution
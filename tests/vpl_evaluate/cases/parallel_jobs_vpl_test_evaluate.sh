@@ -0,0 +1,12 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "Testing 1/4 : Parallel 1" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Testing 4/4 : Parallel 4" "$VPLTESTOUTPUT" >/dev/null || exit 1
+# The first case finishes last, the cases are reported in case order
+[ "$(echo $(grep -e "^Testing" "$VPLTESTOUTPUT" | cut -d " " -f 2))" == "1/4 2/4 3/4 4/4" ] || exit 1
+grep -e "^-Test 3: Parallel 3" "$VPLTESTOUTPUT" >/dev/null || exit 1
+# No time budget settings, no report of the budget
+grep -e "^Time budget" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "Grade :=>> 7.50$" "$VPLTESTOUTPUT" >/dev/null
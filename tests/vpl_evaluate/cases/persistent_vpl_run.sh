@@ -0,0 +1,19 @@
+#!/bin/bash
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+# Adds the numbers of each case and writes the count of cases and the sum
+N=0
+while true ; do
+	SUM=0
+	while read LINE ; do
+		[ "$LINE" == "END" ] && break
+		for A in $LINE ; do
+			SUM=$((SUM + A))
+		done
+	done || exit 0
+	N=$((N + 1))
+	echo "$N $SUM"
+	echo "DONE"
+done
+ENDOFSCRIPT
+chmod +x vpl_execution
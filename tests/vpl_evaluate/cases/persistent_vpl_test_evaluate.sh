@@ -0,0 +1,7 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^-Test 3: Wrong" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^-Test 4" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "Grade :=>> 7.50$" "$VPLTESTOUTPUT" >/dev/null
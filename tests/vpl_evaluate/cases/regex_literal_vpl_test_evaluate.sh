@@ -0,0 +1,7 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^-Test [1-6]" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "^-Test 7" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Grade :=>> 8.57$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,16 @@
+#!/bin/bash
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A
+if [ "$A" == "cpu" ] ; then
+	while true ; do : ; done
+elif [ "$A" == "file" ] ; then
+	exec head -c 100000 /dev/zero > big_file
+elif [ "$A" == "memory" ] ; then
+	B=$(head -c 200000000 /dev/zero | tr '\0' a)
+elif [ "$A" == "fail" ] ; then
+	exit 3
+fi
+echo "$A"
+ENDOFSCRIPT
+chmod +x vpl_execution
@@ -0,0 +1,11 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^Program exceeded the CPU time limit (1s)" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^Program exceeded the file size limit (10 KB)" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "may have exceeded the memory limit (65536 KB)" "$VPLTESTOUTPUT" >/dev/null || exit 1
+# Ending with an error is not a sign of exceeding the memory limit
+[ "$(grep -c -e "exceeded the memory limit" "$VPLTESTOUTPUT")" == "1" ] || exit 1
+grep -e "^-Test 4" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "Grade :=>> 2$" "$VPLTESTOUTPUT" >/dev/null
@@ -0,0 +1,8 @@
+#!/bin/bash
+echo "export VPL_EVAL_RESOURCES=resources.txt" >> vpl_environment.sh
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A
+echo "$A"
+ENDOFSCRIPT
+chmod +x vpl_execution
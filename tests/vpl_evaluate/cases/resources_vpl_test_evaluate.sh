@@ -0,0 +1,8 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^ - Resources: .* CPU .* max RSS [0-9]* KB" "$VPLTESTOUTPUT" >/dev/null || exit 1
+[ "$(grep -c -v "^#" resources.txt)" == "2" ] || exit 1
+grep -P "^1\t[0-9.]+\t[0-9.]+\t[0-9.]+\t[0-9]+\t.*\t0\t0\t1\t0\tPassed$" resources.txt >/dev/null || exit 1
+grep -P "^2\t.*\t0\t0\t0\t0\tFailed$" resources.txt >/dev/null
@@ -0,0 +1,69 @@
+#!/bin/bash
+# Times starting a program with fork+exec, as the evaluator did, and with
+# ProcessLauncher (clone(CLONE_VM | CLONE_VFORK)) from an evaluator with a large heap.
+# Run by hand to see the times: echo "<heap MB> <spawns>" | ./spawn_latency
+cat > spawn_latency.cpp << "ENDOFSOURCE"
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+#define main vpl_main
+#include "vpl_evaluate.cpp.save" // Renamed while vpl_run.sh runs
+#undef main
+
+static const char *programArgv[] = {"/bin/true", NULL};
+static const char *programEnvv[] = {NULL};
+
+static pid_t forkSpawn(int fd) {
+	pid_t pid = fork();
+	if (pid == 0) {
+		dup2(fd, STDIN_FILENO);
+		dup2(fd, STDOUT_FILENO);
+		dup2(fd, STDERR_FILENO);
+		setpgid(0, 0);
+		execve(programArgv[0], (char * const *) programArgv, (char * const *) programEnvv);
+		_exit(127);
+	}
+	return pid;
+}
+
+static pid_t cloneSpawn(int fd) {
+	CaseLimits limits;
+	ProcessLauncher launcher(programArgv[0], programArgv, programEnvv, fd, fd, limits);
+	return launcher.launch();
+}
+
+// Mean microseconds to start the program and wait for its end
+static double spawnTime(pid_t (*spawn)(int), int fd, int spawns) {
+	auto start = chrono::steady_clock::now();
+	for (int i = 0; i < spawns; i++) {
+		pid_t pid = spawn(fd);
+		if (pid <= 0) {
+			printf("Can not start %s\n", programArgv[0]);
+			exit(1);
+		}
+		waitpid(pid, NULL, 0);
+	}
+	chrono::duration<double, micro> elapsed = chrono::steady_clock::now() - start;
+	return elapsed.count() / spawns;
+}
+
+int main() {
+	long megabytes = 0;
+	int spawns = 0;
+	cin >> megabytes >> spawns;
+	vector<char> heap(megabytes << 20, 1); // Pages in use, their tables are copied by fork
+	int fd = open("/dev/null", O_RDWR);
+	double forkTime = spawnTime(forkSpawn, fd, spawns);
+	double cloneTime = spawnTime(cloneSpawn, fd, spawns);
+	printf("heap %ldMB fork+exec+wait %.0fus clone+exec+wait %.0fus\n", megabytes, forkTime, cloneTime);
+	printf(cloneTime < forkTime ? "clone is faster\n" : "clone is slower\n");
+	return heap[0] == 1 ? 0 : 1;
+}
+ENDOFSOURCE
+g++ spawn_latency.cpp -std=c++17 -O2 -pthread -lm -lutil -o spawn_latency
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+./spawn_latency
+ENDOFSCRIPT
+chmod +x vpl_execution
@@ -0,0 +1,6 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^-Test" "$VPLTESTOUTPUT" >/dev/null && exit 1
+grep -e "Grade :=>>10$" "$VPLTESTOUTPUT" >/dev/null
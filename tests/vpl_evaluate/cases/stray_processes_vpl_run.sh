@@ -0,0 +1,15 @@
+#!/bin/bash
+cat > vpl_execution << "ENDOFSCRIPT"
+#!/bin/bash
+read A
+if [ "$A" == "1" ] ; then
+	sleep 30 > /dev/null &
+	setsid sleep 31 > /dev/null &
+else
+	trap '' TERM
+	(sleep 32 > /dev/null &)
+	exec sleep 33
+fi
+echo "$A"
+ENDOFSCRIPT
+chmod +x vpl_execution
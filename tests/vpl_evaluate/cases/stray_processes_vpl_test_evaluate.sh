@@ -0,0 +1,7 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^Stray processes ended: 3$" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "^-Test 2: Ignore TERM" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Grade :=>> 5$" "$VPLTESTOUTPUT" >/dev/null
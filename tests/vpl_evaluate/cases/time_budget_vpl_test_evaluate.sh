@@ -0,0 +1,6 @@
+#!/bin/bash
+if [ -s "$VPLTESTERRORS" ] ; then
+    exit 1
+fi
+grep -e "^Time budget: .* in 3 test cases, 0 timeouts$" "$VPLTESTOUTPUT" >/dev/null || exit 1
+grep -e "Grade :=>>10$" "$VPLTESTOUTPUT" >/dev/null
@@ -59,6 +59,7 @@ function runTest {
 		VPL_GRADEMAX=10
 		VPL_MAXTIME=20
 		VPL_VARIATION=
+		unset $(compgen -v VPL_EVAL_)
 	fi
     cd ..
 }